@@ -0,0 +1,417 @@
+#pragma once
+#include <string>
+#include <random>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../hashjoin/hashjoin.hpp"
+#include "../memory_report.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/barrier.hpp"
+#include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
+#include "../../utils/counting_allocator.hpp"
+#include "../../utils/zipf.hpp"
+
+namespace AggregateBenchmark {
+    // count(*), sum, min and max of the value column per group. The empty aggregate is the identity of merge().
+    struct Aggregate {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = std::numeric_limits<uint64_t>::max();
+        uint64_t max = 0;
+
+        static auto of(uint64_t value) -> Aggregate {
+            return { 1, value, value, value };
+        }
+
+        auto merge(const Aggregate& other) -> void {
+            this->count += other.count;
+            this->sum += other.sum;
+            this->min = std::min(this->min, other.min);
+            this->max = std::max(this->max, other.max);
+        }
+    };
+
+    struct Row {
+        uint64_t key;
+        uint64_t value;
+    };
+
+    using Rows = std::vector<Row>;
+
+    // How the threads share the work of a single GROUP BY
+    enum class Strategy {
+        Shared,         // Every row is merged into one concurrent map
+        Local,          // Every thread pre-aggregates its rows into a private map, the private maps are merged into the concurrent one
+        Partitioned     // Rows are scattered by key into one partition per thread first, every thread aggregates its partition alone
+    };
+
+    inline auto parse_strategy(const std::string& name) -> std::optional<Strategy> {
+        if (name == "shared") {
+            return Strategy::Shared;
+        } else if (name == "local") {
+            return Strategy::Local;
+        } else if (name == "partitioned") {
+            return Strategy::Partitioned;
+        }
+
+        return {};
+    }
+
+    inline auto strategy_name(Strategy strategy) -> std::string {
+        switch (strategy) {
+            case Strategy::Local: return "local";
+            case Strategy::Partitioned: return "partitioned";
+            default: return "shared";
+        }
+    }
+
+    // Names of the two phases of a run, a shared aggregation has only the first
+    inline auto phase_names(Strategy strategy) -> std::pair<std::string, std::string> {
+        switch (strategy) {
+            case Strategy::Local: return { "aggregate", "merge" };
+            case Strategy::Partitioned: return { "partition", "aggregate" };
+            default: return { "aggregate", "" };
+        }
+    }
+
+    struct RowOptions {
+        uint64_t seed;
+        uint64_t num_rows;              // 0 for exactly the rows of dataset B
+        uint64_t num_groups;            // 0 to group by the foreign keys of dataset B
+        double zipf;                    // Skew of the drawn group keys, 0 for uniform
+    };
+
+    struct BenchmarkOptions {
+        Strategy strategy;
+        uint64_t expected_hash;         // Of the single threaded aggregation, see expected_hash()
+    };
+
+    // Rows take their values from the id column of dataset B, repeated as often as needed. Their keys are the foreign keys,
+    // or drawn over [0, num_groups) when grouping by a synthetic key, since dataset B only references a few thousand ids.
+    inline auto generate_rows(const HashJoinBenchmark::DatasetB& dataset_b, const RowOptions& options) -> Rows {
+        auto num_rows = options.num_rows > 0 ? options.num_rows : dataset_b.size();
+        Rows rows(dataset_b.empty() ? 0 : num_rows);
+
+        std::mt19937_64 rng(options.seed);
+        std::uniform_int_distribution<uint64_t> uniform(0, std::max<uint64_t>(options.num_groups, 1) - 1);
+        std::optional<ScrambledZipfDistribution> zipf;
+
+        // A single group has nothing to skew, and the Zipfian generator needs at least two keys
+        if (options.num_groups >= 2 && options.zipf > 0.0) {
+            zipf.emplace(options.num_groups, options.zipf);
+        }
+
+        for (uint64_t i = 0; i < rows.size(); i++) {
+            auto& item = dataset_b[i % dataset_b.size()];
+            rows[i].value = std::get<0>(item);
+
+            if (options.num_groups == 0) {
+                rows[i].key = std::get<1>(item);
+            } else {
+                rows[i].key = zipf ? (*zipf)(rng) : uniform(rng);
+            }
+        }
+
+        return rows;
+    }
+
+    inline auto mix(uint64_t value) -> uint64_t {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+
+        return value;
+    }
+
+    // Groups come out of the maps in any order, so their hashes are summed up
+    inline auto hash_group(uint64_t key, const Aggregate& aggregate) -> uint64_t {
+        return mix(key ^ mix(aggregate.count ^ mix(aggregate.sum ^ mix(aggregate.min ^ mix(aggregate.max)))));
+    }
+
+    // Partition of a key, independent of the bits the maps hash with
+    inline auto partition_of(uint64_t key, uint32_t num_partitions) -> uint32_t {
+        return static_cast<uint32_t>(((mix(key) >> 32) * num_partitions) >> 32);
+    }
+
+    // Private map of a thread pre-aggregating its rows
+    using LocalMap = std::unordered_map<uint64_t, Aggregate, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, Aggregate>>;
+
+    // Hash of the correct result, every run of every strategy and map has to produce it
+    inline auto expected_hash(const Rows& rows) -> uint64_t {
+        std::unordered_map<uint64_t, Aggregate> groups;
+        uint64_t hash = 0;
+
+        for (auto& row : rows) {
+            groups[row.key].merge(Aggregate::of(row.value));
+        }
+
+        for (auto& [key, aggregate] : groups) {
+            hash += hash_group(key, aggregate);
+        }
+
+        return hash;
+    }
+
+    // Scattered rows, buffers[source thread][partition]
+    using PartitionBuffers = std::vector<std::vector<Rows>>;
+
+    struct ThreadStats {
+        uint64_t num_local_groups = 0;  // Groups the thread merged into the shared map (local strategy)
+    };
+
+    template<typename T>
+    inline auto benchmark_worker(SpinBarrier& barrier, const Rows& rows, const BenchmarkOptions& options, T& map, std::vector<T>& partitions, PartitionBuffers& buffers, uint32_t thread, uint32_t num_threads, PhaseTimes& first, PhaseTimes& second, PerfTotals& perf, ThreadStats& stats) -> void {
+        auto start = rows.size() * thread / num_threads;
+        auto end = rows.size() * (thread + 1) / num_threads;
+
+        PerfCounters counters;
+        barrier.arrive_and_wait();
+        first.begin(thread);
+        counters.start();
+
+        if (options.strategy == Strategy::Shared) {
+            for (auto i = start; i < end; i++) {
+                map.update(rows[i].key, Aggregate::of(rows[i].value));
+                first.set_progress(thread, i - start + 1);
+            }
+
+            counters.stop();
+            first.end(thread);
+        } else if (options.strategy == Strategy::Local) {
+            LocalMap local;
+
+            for (auto i = start; i < end; i++) {
+                local[rows[i].key].merge(Aggregate::of(rows[i].value));
+                first.set_progress(thread, i - start + 1);
+            }
+
+            first.end(thread);
+
+            // Every thread merges as soon as all of them are done, the pre-aggregation isn't timed separately otherwise
+            barrier.arrive_and_wait();
+            second.begin(thread);
+            uint64_t num_merged = 0;
+
+            for (auto& [key, aggregate] : local) {
+                map.update(key, aggregate);
+                second.set_progress(thread, ++num_merged);
+            }
+
+            counters.stop();
+            second.end(thread);
+            stats.num_local_groups = num_merged;
+        } else {
+            auto& scattered = buffers[thread];
+
+            for (auto& partition : scattered) {
+                partition.reserve((end - start) / num_threads + 1);
+            }
+
+            for (auto i = start; i < end; i++) {
+                scattered[partition_of(rows[i].key, num_threads)].push_back(rows[i]);
+                first.set_progress(thread, i - start + 1);
+            }
+
+            first.end(thread);
+
+            // The partition of this thread is complete once every thread scattered its rows
+            barrier.arrive_and_wait();
+            second.begin(thread);
+            auto& partition = partitions[thread];
+            uint64_t num_aggregated = 0;
+
+            for (auto& source : buffers) {
+                for (auto& row : source[thread]) {
+                    partition.update(row.key, Aggregate::of(row.value));
+                    second.set_progress(thread, ++num_aggregated);
+                }
+            }
+
+            counters.stop();
+            second.end(thread);
+        }
+
+        // An operation is a single row, whatever the strategy did with it
+        perf.add(counters.read(), end - start);
+    }
+
+    template<typename T>
+    inline auto benchmark_impl(const Rows& rows, const BenchmarkOptions& options, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
+        T map;
+        RunResult result{};
+
+        auto partitioned = options.strategy == Strategy::Partitioned;
+        auto two_phases = options.strategy != Strategy::Shared;
+        auto names = phase_names(options.strategy);
+
+        // Partitions use the benchmarked map as well, with a single writer each
+        std::vector<T> partitions(partitioned ? num_threads : 0);
+        PartitionBuffers buffers(partitioned ? num_threads : 0, std::vector<Rows>(num_threads));
+
+        SpinBarrier barrier(num_threads + 1);
+        PerfTotals perf;
+        PhaseTimes first_times(num_threads);
+        PhaseTimes second_times(num_threads);
+        std::vector<ThreadStats> stats(num_threads);
+
+        TaskGroup workers;
+        for (uint32_t i = 0; i < num_threads; i++) {
+            workers.run(
+                i,
+                &benchmark_worker<T>,
+                std::ref(barrier),
+                std::cref(rows),
+                std::cref(options),
+                std::ref(map),
+                std::ref(partitions),
+                std::ref(buffers),
+                i,
+                num_threads,
+                std::ref(first_times),
+                std::ref(second_times),
+                std::ref(perf),
+                std::ref(stats[i])
+            );
+        }
+
+        Timer first;
+        Timer second;
+        ThroughputSampler first_sampler(first_times);
+        ThroughputSampler second_sampler(second_times);
+
+        barrier.arrive_and_wait();
+        first.start_at(barrier.get_release_timepoint());
+        first_sampler.start(first.get_start());
+
+        if (two_phases) {
+            barrier.arrive_and_wait();
+            first.end_at(barrier.get_release_timepoint());
+            first_sampler.stop();
+
+            second.start_at(barrier.get_release_timepoint());
+            second_sampler.start(second.get_start());
+        }
+
+        workers.wait();
+
+        if (two_phases) {
+            second.end();
+            second_sampler.stop();
+        } else {
+            first.end();
+            first_sampler.stop();
+        }
+
+        // Tables replaced while growing, no worker probes them anymore
+        reclaim_map(map);
+        for (auto& partition : partitions) {
+            reclaim_map(partition);
+        }
+
+        first_times.report(result, names.first, first);
+        first_sampler.report(result, names.first);
+
+        if (two_phases) {
+            second_times.report(result, names.second, second);
+            second_sampler.report(result, names.second);
+        }
+
+        uint64_t num_groups = 0;
+        uint64_t hash = 0;
+        auto collect = [&](uint64_t key, const Aggregate& aggregate) {
+            num_groups++;
+            hash += hash_group(key, aggregate);
+        };
+
+        if (partitioned) {
+            for (auto& partition : partitions) {
+                partition.for_each(collect);
+            }
+        } else {
+            map.for_each(collect);
+        }
+
+        auto duration = first.get_duration() + (two_phases ? second.get_duration() : 0);
+
+        result.value = duration;
+        result.hash = hash;
+
+        result.metrics["ops_per_sec"] = duration > 0 ? rows.size() * 1e9 / duration : 0.0;
+        result.metrics["num_groups"] = num_groups;
+
+        std::cout << "Aggregated " << rows.size() << " rows into " << num_groups << " groups";
+
+        if (options.strategy == Strategy::Local) {
+            // How much the pre-aggregation saved the shared map, 1 when every thread saw every group
+            uint64_t num_local_groups = 0;
+            for (auto& thread_stats : stats) {
+                num_local_groups += thread_stats.num_local_groups;
+            }
+
+            result.metrics["local_groups"] = num_local_groups;
+            std::cout << ", " << num_local_groups << " thread local groups merged";
+        } else if (partitioned) {
+            // Share of the rows in the largest partition, 1 / threads when perfectly balanced
+            uint64_t largest = 0;
+            for (uint32_t partition = 0; partition < num_threads; partition++) {
+                uint64_t size = 0;
+                for (auto& source : buffers) {
+                    size += source[partition].size();
+                }
+
+                largest = std::max(largest, size);
+            }
+
+            result.metrics["largest_partition_share"] = rows.empty() ? 0.0 : static_cast<double>(largest) / rows.size();
+            std::cout << ", largest partition holds " << largest << " rows";
+        }
+
+        std::cout << std::endl;
+
+        perf.report(result);
+
+        memory.finish();
+        report_memory(result, memory, num_groups);
+
+        if (partitioned) {
+            introspect_maps(partitions.begin(), partitions.end(), result);
+        } else {
+            introspect_map(map, result);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    inline auto run_benchmark(const std::string& impl, const Rows& rows, const BenchmarkOptions& options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
+        BenchmarkResult result{};
+
+        result.impl = impl;
+        result.value_unit = "ns";
+        result.num_threads = num_threads;
+
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(rows, options, num_threads);
+        });
+
+        // Runs agreeing with each other isn't enough, they have to agree with the single threaded aggregation
+        result.correct = result.correct && result.hash == options.expected_hash;
+
+        return result;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "libcuckoo.hpp"
+#include "stdmap.hpp"
+#include "tbbmap.hpp"
+#include "swiss.hpp"
+#include "../registry.hpp"
+
+namespace AggregateBenchmark {
+    // Implementations selectable with --implementation, in the order "all" runs them.
+    // Junction can't merge into a value in place and isn't part of this benchmark.
+    struct CuckooImpl {
+        using Map = CuckooMap;
+        static constexpr const char* name = "libcuckoo";
+        static constexpr const char* description = "libcuckoo";
+    };
+
+    struct TBBHashImpl {
+        using Map = TBBHashMap;
+        static constexpr const char* name = "tbb-hash";
+        static constexpr const char* description = "TBB concurrent_hash_map";
+    };
+
+    struct TBBUnorderedImpl {
+        using Map = TBBUnorderedMap;
+        static constexpr const char* name = "tbb-unordered";
+        static constexpr const char* description = "TBB concurrent_unordered_map";
+    };
+
+    struct STDBlockingImpl {
+        using Map = STDMap;
+        static constexpr const char* name = "std-blocking";
+        static constexpr const char* description = "Blocking STD";
+    };
+
+    struct SwissImpl {
+        using Map = SwissMap;
+        static constexpr const char* name = "swiss";
+        static constexpr const char* description = "Concurrent Swiss table (SSE2 groups, seqlock reads)";
+    };
+
+    using Implementations = Registry<
+        CuckooImpl,
+        TBBHashImpl,
+        TBBUnorderedImpl,
+        STDBlockingImpl,
+        SwissImpl
+    >;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "aggregate.hpp"
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace AggregateBenchmark {
+    class CuckooMap {
+        public:
+            auto update(uint64_t key, const Aggregate& delta) -> void {
+                this->map.upsert(key, [&](Aggregate& aggregate) {
+                    aggregate.merge(delta);
+                }, delta);
+            }
+
+            template<typename F>
+            auto for_each(F&& f) -> void {
+                auto lt = this->map.lock_table();
+
+                for (auto& [key, aggregate] : lt) {
+                    f(key, aggregate);
+                }
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            libcuckoo::cuckoohash_map<uint64_t, Aggregate, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, Aggregate>> map;
+    };
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "aggregate.hpp"
+#include <unordered_map>
+#include <mutex>
+
+namespace AggregateBenchmark {
+    class STDMap {
+        public:
+            auto update(uint64_t key, const Aggregate& delta) -> void {
+                std::lock_guard lock(this->mtx);
+                this->map[key].merge(delta);
+            }
+
+            template<typename F>
+            auto for_each(F&& f) -> void {
+                for (auto& [key, aggregate] : this->map) {
+                    f(key, aggregate);
+                }
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            std::unordered_map<uint64_t, Aggregate, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, Aggregate>> map;
+            std::mutex mtx;
+    };
+}
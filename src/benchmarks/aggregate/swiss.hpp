@@ -0,0 +1,31 @@
+#pragma once
+#include "aggregate.hpp"
+#include "../../utils/swiss_map.hpp"
+
+namespace AggregateBenchmark {
+    class SwissMap {
+        public:
+            auto update(uint64_t key, const Aggregate& delta) -> void {
+                this->map.insert_or_modify(key, delta, [&](Aggregate& aggregate) {
+                    aggregate.merge(delta);
+                });
+            }
+
+            template<typename F>
+            auto for_each(F&& f) -> void {
+                this->map.for_each(f);
+            }
+
+            // Only between phases
+            auto reclaim() -> void {
+                this->map.reclaim();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            ConcurrentSwissMap<uint64_t, Aggregate> map;
+    };
+}
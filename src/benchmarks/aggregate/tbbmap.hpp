@@ -0,0 +1,71 @@
+#pragma once
+#include "aggregate.hpp"
+#include <atomic>
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_unordered_map.h>
+
+namespace AggregateBenchmark {
+    class TBBHashMap {
+        public:
+            auto update(uint64_t key, const Aggregate& delta) -> void {
+                MapType::accessor accessor;
+                this->map.insert(accessor, key);
+                accessor->second.merge(delta);
+            }
+
+            template<typename F>
+            auto for_each(F&& f) -> void {
+                for (auto& [key, aggregate] : this->map) {
+                    f(key, aggregate);
+                }
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            using MapType = tbb::concurrent_hash_map<uint64_t, Aggregate, tbb::tbb_hash_compare<uint64_t>, MapAllocator<uint64_t, Aggregate>>;
+            MapType map;
+    };
+
+    // The map can't lock an entry, so every aggregate is a set of atomics updated without a lock
+    class TBBUnorderedMap {
+        public:
+            auto update(uint64_t key, const Aggregate& delta) -> void {
+                auto& aggregate = this->map[key];
+
+                aggregate.count.fetch_add(delta.count, std::memory_order_relaxed);
+                aggregate.sum.fetch_add(delta.sum, std::memory_order_relaxed);
+
+                auto min = aggregate.min.load(std::memory_order_relaxed);
+                while (delta.min < min && !aggregate.min.compare_exchange_weak(min, delta.min, std::memory_order_relaxed)) {
+                }
+
+                auto max = aggregate.max.load(std::memory_order_relaxed);
+                while (delta.max > max && !aggregate.max.compare_exchange_weak(max, delta.max, std::memory_order_relaxed)) {
+                }
+            }
+
+            template<typename F>
+            auto for_each(F&& f) -> void {
+                for (auto& [key, aggregate] : this->map) {
+                    f(key, Aggregate{ aggregate.count.load(), aggregate.sum.load(), aggregate.min.load(), aggregate.max.load() });
+                }
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            struct AtomicAggregate {
+                std::atomic<uint64_t> count = 0;
+                std::atomic<uint64_t> sum = 0;
+                std::atomic<uint64_t> min = std::numeric_limits<uint64_t>::max();
+                std::atomic<uint64_t> max = 0;
+            };
+
+            tbb::concurrent_unordered_map<uint64_t, AtomicAggregate, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, AtomicAggregate>> map;
+    };
+}
@@ -2,10 +2,68 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <map>
+
+// Per worker timepoints of a benchmark phase, in ns relative to the phase's start on the main thread
+struct PhaseResult {
+    std::string name;
+    uint64_t duration_ns;
+
+    std::vector<uint64_t> thread_starts;
+    std::vector<uint64_t> thread_ends;
+};
+
+// A value sampled while a benchmark phase ran, usually its throughput (see throughput_sampler.hpp)
+struct TimeSeries {
+    std::string name;
+    uint32_t interval_ms;
+    std::string unit;                       // ops/s, ns or bytes
+
+    std::vector<uint64_t> time_ns;          // End of each sample, relative to the phase's start
+    std::vector<uint64_t> values;           // E.g. the throughput of all workers during the sample
+};
 
 struct RunResult {
     uint64_t value;
     uint64_t hash;
+
+    // Additional benchmark specific measurements (name -> value)
+    std::map<std::string, double> metrics;
+
+    // Phases timed by the workers themselves
+    std::vector<PhaseResult> phases;
+
+    // Throughput over time, only with --sample-ms
+    std::vector<TimeSeries> timeseries;
+
+    // Outside of Tukey's fences of all runs
+    bool outlier = false;
+};
+
+// Spread of the runs' values, see statistics.hpp
+struct RunStatistics {
+    double median;
+    double mean;
+    double stddev;
+
+    // Bootstrap confidence interval of the median
+    double confidence;
+    double ci_low;
+    double ci_high;
+    double ci_half_width_pct;
+
+    double outlier_low;
+    double outlier_high;
+    uint32_t num_outliers;
+};
+
+// Where the worker threads ran, cpus and nodes are listed per thread (empty when unpinned)
+struct ThreadLayout {
+    std::string affinity;
+    std::string placement;
+
+    std::vector<uint32_t> cpus;
+    std::vector<uint32_t> nodes;
 };
 
 struct BenchmarkResult {
@@ -18,12 +76,30 @@ struct BenchmarkResult {
     uint64_t avg_value;
     uint64_t min_value;
     uint64_t max_value;
-    uint64_t mean_value;
+    uint64_t mean_value;        // Median of the runs, named mean for compatibility
+
+    RunStatistics stats;
 
     uint64_t hash;
 
     uint32_t num_threads;
     uint32_t num_runs;
+    uint32_t num_warmup;
+
+    // Bytes per key and value, only set by benchmarks sweeping entry sizes (--sizes)
+    uint32_t key_size = 0;
+    uint32_t value_size = 0;
+
+    // Where the map allocated its memory (--allocator)
+    std::string allocator;
+
+    // Page size behind the maps and datasets (--hugepages)
+    std::string hugepages;
+
+    // Benchmark specific setting the result was run with (e.g. the aggregation strategy), empty if there's none
+    std::string variant;
+
+    ThreadLayout layout;
 
     bool correct;
 };
\ No newline at end of file
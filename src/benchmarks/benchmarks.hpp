@@ -1,15 +1,9 @@
 #pragma once
 
-#include "wordcount/libcuckoo.hpp"
-#include "wordcount/stdmap.hpp"
-#include "wordcount/tbbmap.hpp"
-
-#include "hashjoin/libcuckoo.hpp"
-#include "hashjoin/stdmap.hpp"
-#include "hashjoin/tbbmap.hpp"
-#include "hashjoin/junction.hpp"
-
-#include "cache/libcuckoo.hpp"
-#include "cache/stdmap.hpp"
-#include "cache/tbbmap.hpp"
-#include "cache/junction.hpp"
\ No newline at end of file
+#include "wordcount/implementations.hpp"
+#include "hashjoin/implementations.hpp"
+#include "cache/implementations.hpp"
+#include "ycsb/implementations.hpp"
+#include "grow/implementations.hpp"
+#include "churn/implementations.hpp"
+#include "aggregate/implementations.hpp"
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <optional>
+#include <string>
+#include "../../utils/timer.hpp"
+
+namespace CacheBenchmark {
+    enum class BackendWait {
+        Busy,       // Spin for the whole latency (and while waiting for an in-flight load)
+        Park        // Sleep
+    };
+
+    inline auto parse_backend_wait(const std::string& name) -> std::optional<BackendWait> {
+        if (name == "busy") {
+            return BackendWait::Busy;
+        } else if (name == "park") {
+            return BackendWait::Park;
+        }
+
+        return {};
+    }
+
+    // Simulated slow backend, every cache miss fetches the value from here.
+    // With coalescing (single-flight) only one of the threads concurrently missing on a key loads it,
+    // the others wait until the loader has inserted the value into the map.
+    class Backend {
+        public:
+            Backend(uint64_t latency_ns, BackendWait wait, bool coalesce) : latency_ns(latency_ns), wait(wait), coalesce(coalesce) {
+            }
+
+            // Returns true if the caller loaded the key and has to call complete(key) once the value is in the map
+            auto fetch(uint64_t key) -> bool {
+                if (!this->coalesce) {
+                    this->load();
+                    return false;
+                }
+
+                auto& shard = this->shards[key % NUM_SHARDS];
+                std::shared_ptr<Flight> flight;
+
+                {
+                    std::lock_guard<std::mutex> lock(shard.mtx);
+                    auto [it, inserted] = shard.flights.try_emplace(key);
+
+                    if (inserted) {
+                        it->second = std::make_shared<Flight>();
+                    } else {
+                        flight = it->second;
+                    }
+                }
+
+                // We are the leader
+                if (!flight) {
+                    this->load();
+                    return true;
+                }
+
+                this->num_coalesced.fetch_add(1, std::memory_order_relaxed);
+
+                if (this->wait == BackendWait::Busy) {
+                    while (!flight->done.load(std::memory_order_acquire)) {
+                    }
+                } else {
+                    std::unique_lock<std::mutex> lock(flight->mtx);
+                    flight->var.wait(lock, [&flight]() { return flight->done.load(); });
+                }
+
+                return false;
+            }
+
+            auto complete(uint64_t key) -> void {
+                auto& shard = this->shards[key % NUM_SHARDS];
+                std::shared_ptr<Flight> flight;
+
+                {
+                    std::lock_guard<std::mutex> lock(shard.mtx);
+                    auto it = shard.flights.find(key);
+                    flight = std::move(it->second);
+                    shard.flights.erase(it);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(flight->mtx);
+                    flight->done.store(true, std::memory_order_release);
+                }
+
+                flight->var.notify_all();
+            }
+
+            auto get_num_calls() const -> uint64_t {
+                return this->num_calls.load();
+            }
+
+            auto get_num_coalesced() const -> uint64_t {
+                return this->num_coalesced.load();
+            }
+
+        private:
+            struct Flight {
+                std::atomic<bool> done = false;
+                std::mutex mtx;
+                std::condition_variable var;
+            };
+
+            struct Shard {
+                std::mutex mtx;
+                std::unordered_map<uint64_t, std::shared_ptr<Flight>> flights;
+            };
+
+            static constexpr uint64_t NUM_SHARDS = 64;
+
+            auto load() -> void {
+                this->num_calls.fetch_add(1, std::memory_order_relaxed);
+
+                if (this->wait == BackendWait::Busy) {
+                    auto start = get_timepoint();
+                    while (get_duration(start, get_timepoint()) < this->latency_ns) {
+                    }
+                } else {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(this->latency_ns));
+                }
+            }
+
+            uint64_t latency_ns;
+            BackendWait wait;
+            bool coalesce;
+
+            std::array<Shard, NUM_SHARDS> shards{};
+
+            std::atomic<uint64_t> num_calls = 0;
+            std::atomic<uint64_t> num_coalesced = 0;
+    };
+}
@@ -4,14 +4,183 @@
 #include <cstdint>
 #include <atomic>
 #include <algorithm>
+#include <optional>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include "timing_wheel.hpp"
+#include "backend.hpp"
 #include "../benchmark.hpp"
-#include "../../utils/semaphore.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
+#include "../../utils/slab_allocator.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/zipf.hpp"
+#include "../../utils/span.hpp"
+#include "../../utils/barrier.hpp"
 #include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
 #include "../../utils/debug.hpp"
 
 namespace CacheBenchmark {
-    // No timestamp
-    using CacheData = uint64_t;
+    // Deadlines are absolute milliseconds of a monotonic clock
+    constexpr uint64_t NEVER_EXPIRES = std::numeric_limits<uint64_t>::max() >> 3;
+
+    // Variable size value, allocated from the run's slab allocator
+    struct Payload {
+        uint64_t expires_at;    // Copy of the entry's deadline, for maps which can only store a pointer
+        uint64_t size;
+
+        auto data() -> uint8_t* {
+            return reinterpret_cast<uint8_t*>(this + 1);
+        }
+    };
+
+    struct CacheData {
+        uint64_t value;
+        uint64_t expires_at;
+        Payload* payload;       // Only used with variable size values
+    };
+
+    enum class TTLDistribution {
+        None,           // Entries never expire
+        Fixed,          // Every entry lives exactly ttl ms
+        Uniform,        // Uniformly distributed in [1, 2 * ttl] ms
+        Exponential     // Exponentially distributed with a mean of ttl ms
+    };
+
+    enum class ExpiryPolicy {
+        Lazy,           // Expired entries are only noticed (and renewed) when read
+        Wheel           // Lazy + an expirer thread erases due entries using a timing wheel
+    };
+
+    inline auto parse_ttl_distribution(const std::string& name) -> std::optional<TTLDistribution> {
+        if (name == "none") {
+            return TTLDistribution::None;
+        } else if (name == "fixed") {
+            return TTLDistribution::Fixed;
+        } else if (name == "uniform") {
+            return TTLDistribution::Uniform;
+        } else if (name == "exponential") {
+            return TTLDistribution::Exponential;
+        }
+
+        return {};
+    }
+
+    inline auto parse_expiry_policy(const std::string& name) -> std::optional<ExpiryPolicy> {
+        if (name == "lazy") {
+            return ExpiryPolicy::Lazy;
+        } else if (name == "wheel") {
+            return ExpiryPolicy::Wheel;
+        }
+
+        return {};
+    }
+
+    inline auto now_ms() -> uint64_t {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    }
+
+    enum class EvictionPolicy {
+        Cleaner,        // A single cleaner thread sweeps the whole key space
+        Partitioned,    // Multiple cleaner threads, each sweeping its own key range
+        Sampled         // No cleaner, accessors evict sampled keys themselves (Redis style)
+    };
+
+    inline auto parse_eviction_policy(const std::string& name) -> std::optional<EvictionPolicy> {
+        if (name == "cleaner") {
+            return EvictionPolicy::Cleaner;
+        } else if (name == "partitioned") {
+            return EvictionPolicy::Partitioned;
+        } else if (name == "sampled") {
+            return EvictionPolicy::Sampled;
+        }
+
+        return {};
+    }
+
+    struct BenchmarkOptions {
+        uint64_t seed;
+        uint64_t time_limit;
+        uint64_t map_capacity;
+
+        EvictionPolicy eviction = EvictionPolicy::Cleaner;
+        uint32_t num_cleaners = 1;
+        uint32_t num_samples = 5;
+
+        TTLDistribution ttl = TTLDistribution::None;
+        uint64_t ttl_ms = 1000;
+        ExpiryPolicy expiry = ExpiryPolicy::Lazy;
+
+        // Value sizes are log-uniformly distributed in [value_min, value_max], 0 disables values.
+        // With values the map is bounded by capacity_bytes (of slab chunks) instead of map_capacity entries.
+        uint32_t value_min = 64;
+        uint32_t value_max = 0;
+        uint64_t capacity_bytes = 256 * 1024 * 1024;
+
+        // Misses are fetched from a simulated backend, 0 disables it
+        uint64_t backend_latency_ns = 0;
+        BackendWait backend_wait = BackendWait::Busy;
+        bool coalesce = false;
+
+        // Zipfian key popularity, 0 means uniform
+        double zipf = 0.0;
+
+        // Keys looked up per access_batch call, 1 uses single accesses
+        uint32_t batch_size = 1;
+    };
+
+    // Per run objects shared by all accessors
+    struct RunContext {
+        TimingWheel* wheel = nullptr;
+        SlabAllocator* slab = nullptr;
+        Backend* backend = nullptr;
+        const ScrambledZipfDistribution* zipf = nullptr;
+    };
+
+    struct AccessorState {
+        EvictionPolicy eviction = EvictionPolicy::Cleaner;
+        uint32_t num_samples = 5;
+        uint64_t num_ids = 0;
+        std::mt19937_64 rng{};
+
+        TTLDistribution ttl = TTLDistribution::None;
+        uint64_t ttl_ms = 0;
+        TimingWheel* wheel = nullptr;
+
+        SlabAllocator* slab = nullptr;
+        uint32_t value_min = 0;
+        uint32_t value_max = 0;
+        std::vector<uint8_t> buffer{};
+
+        Backend* backend = nullptr;
+        std::vector<uint64_t> fetches{};
+        uint64_t backend_ns = 0;
+
+        // Scratch space of access_batch
+        std::vector<uint64_t> batch_keys{};
+        std::vector<CacheData> batch_entries{};
+
+        uint64_t stall_ns = 0;
+        uint64_t num_stalls = 0;
+        uint64_t num_evictions = 0;
+        uint64_t num_expired = 0;
+    };
+
+    inline auto accessor_state() -> AccessorState& {
+        // Each accessor thread gets it's own state, so maps don't need to pass it around
+        return WorkerPool::local<AccessorState>();
+    }
 
     auto busy_sleep(uint64_t num_ns) -> void {
         auto start = get_timepoint();
@@ -23,32 +192,290 @@ namespace CacheBenchmark {
         } while (get_duration(start, now) < num_ns);
     }
 
+    // Creates a new entry for a missed (or expired) key. The map schedules it's expiry with schedule_entry() once it's
+    // in the map, an entry that lost the race for the key is only released.
+    inline auto make_entry(uint64_t key) -> CacheData {
+        auto& state = accessor_state();
+
+        // Fetch the value first, might wait for another thread already fetching it
+        if (state.backend) {
+            auto start = get_timepoint();
+
+            if (state.backend->fetch(key)) {
+                state.fetches.push_back(key);
+            }
+
+            state.backend_ns += get_duration(start, get_timepoint());
+        }
+
+        uint64_t ttl = 0;
+        switch (state.ttl) {
+            case TTLDistribution::None:
+                break;
+            case TTLDistribution::Fixed:
+                ttl = state.ttl_ms;
+                break;
+            case TTLDistribution::Uniform:
+                ttl = std::uniform_int_distribution<uint64_t>(1, 2 * state.ttl_ms)(state.rng);
+                break;
+            case TTLDistribution::Exponential:
+                ttl = static_cast<uint64_t>(std::exponential_distribution<double>(1.0 / state.ttl_ms)(state.rng));
+                break;
+        }
+
+        CacheData entry{ key, NEVER_EXPIRES, nullptr };
+
+        if (state.ttl != TTLDistribution::None) {
+            entry.expires_at = now_ms() + std::max<uint64_t>(ttl, 1);
+        }
+
+        if (state.slab) {
+            auto log_min = std::log(static_cast<double>(std::max<uint32_t>(state.value_min, 1)));
+            auto log_max = std::log(static_cast<double>(state.value_max));
+            auto size = static_cast<uint64_t>(std::exp(std::uniform_real_distribution<double>(log_min, log_max)(state.rng)));
+            size = std::clamp<uint64_t>(size, state.value_min, state.value_max);
+
+            // Fill in the value, as if it was fetched
+            auto payload = new (state.slab->allocate(sizeof(Payload) + size)) Payload{ entry.expires_at, size };
+            std::memset(payload->data(), static_cast<uint8_t>(key), size);
+            entry.payload = payload;
+        }
+
+        return entry;
+    }
+
+    // Called by the maps for every entry from make_entry() that got inserted (or renewed an expired one)
+    inline auto schedule_entry(const CacheData& entry) -> void {
+        auto& state = accessor_state();
+
+        if (state.wheel && entry.expires_at != NEVER_EXPIRES) {
+            state.wheel->schedule(entry.value, entry.expires_at);
+        }
+    }
+
+    // Called after every access, wakes up threads waiting for the keys we have fetched (and inserted)
+    inline auto complete_fetches() -> void {
+        auto& state = accessor_state();
+
+        for (auto key : state.fetches) {
+            state.backend->complete(key);
+        }
+
+        state.fetches.clear();
+    }
+
+    // Frees the entry's value, has to be called by whoever removes the entry from the map
+    inline auto release_entry(const CacheData& entry) -> void {
+        if (entry.payload) {
+            accessor_state().slab->deallocate(entry.payload, sizeof(Payload) + entry.payload->size);
+        }
+    }
+
+    // How much of the map's capacity an entry takes, bytes of the backing chunk with values, 1 otherwise
+    inline auto entry_charge(const CacheData& entry) -> uint64_t {
+        if (entry.payload) {
+            return accessor_state().slab->chunk_size(sizeof(Payload) + entry.payload->size);
+        }
+
+        return 1;
+    }
+
+    // Copies the value out, as if it was served
+    inline auto read_entry(const CacheData& entry) -> void {
+        if (entry.payload) {
+            auto& buffer = accessor_state().buffer;
+
+            // Junction readers may race with a reuse of the chunk, never copy more than we have room for
+            auto size = std::min<uint64_t>(entry.payload->size, buffer.size());
+            std::memcpy(buffer.data(), entry.payload->data(), size);
+        }
+    }
+
+    inline auto is_expired(const CacheData& entry) -> bool {
+        return entry.expires_at != NEVER_EXPIRES && entry.expires_at <= now_ms();
+    }
+
+    // Lazy expiry, replaces an expired entry (as if it was fetched again) in place.
+    // Returns the change of the entry's charge (wrapping around when it shrinks)
+    inline auto renew_entry(CacheData& entry, const CacheData& fresh) -> uint64_t {
+        auto charge = entry_charge(fresh) - entry_charge(entry);
+
+        release_entry(entry);
+        entry = fresh;
+        accessor_state().num_expired++;
+
+        return charge;
+    }
+
+    // Between eviction attempts that made no progress, spins at first and then lets the threads it waits for run
+    inline auto backoff(uint32_t attempt) -> void {
+        constexpr uint32_t SPIN_LIMIT = 64;
+
+        if (attempt < SPIN_LIMIT) {
+            cpu_relax();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    // Called by the maps before inserting a missed key, blocks while we have less than 2% of free space
+    template<typename T>
+    inline auto make_space(T& map) -> void {
+        auto capacity = map.get_capacity();
+        auto limit = capacity - (capacity / 50);
+
+        if (map.get_size() <= limit) {
+            return;
+        }
+
+        auto& state = accessor_state();
+        auto start = get_timepoint();
+
+        if (state.eviction == EvictionPolicy::Sampled) {
+            std::uniform_int_distribution<uint64_t> dist(0, state.num_ids);
+
+            // Evict the first sampled key that is actually cached
+            for (uint32_t misses = 0; map.get_size() > limit;) {
+                auto evicted = false;
+
+                for (uint32_t i = 0; i < state.num_samples && !evicted; i++) {
+                    evicted = map.erase(dist(state.rng));
+                }
+
+                if (evicted) {
+                    state.num_evictions++;
+                } else {
+                    // The samples keep missing (a sparse key space, or other threads erased them first)
+                    backoff(misses++);
+                }
+            }
+        } else {
+            // Wait for the cleaner(s)
+            for (uint32_t waits = 0; map.get_size() > limit; waits++) {
+                backoff(waits);
+            }
+        }
+
+        state.stall_ns += get_duration(start, get_timepoint());
+        state.num_stalls++;
+    }
+
+    // Second half of access_batch, creates entries for the keys missed in the first (read only) pass.
+    // Misses are deduplicated and fetched in key order: a thread only completes it's fetches once the whole batch
+    // is inserted, so waiting for another thread's fetch (of a larger key) can never close a cycle.
+    template<typename T>
+    inline auto prepare_entries(T& map, std::vector<uint64_t>& misses) -> std::vector<CacheData>& {
+        auto& entries = accessor_state().batch_entries;
+        entries.clear();
+
+        std::sort(misses.begin(), misses.end());
+        misses.erase(std::unique(misses.begin(), misses.end()), misses.end());
+
+        for (auto key : misses) {
+            // Wait (or evict) while we have less than 2% of free space
+            make_space(map);
+            entries.push_back(make_entry(key));
+        }
+
+        return entries;
+    }
+
     template<typename T>
-    inline auto benchmark_accessor(Semaphore& sem, T& map, uint64_t seed, const std::atomic<bool>& done, std::atomic<uint64_t>& num_accesses, uint64_t num_ids) -> void {
-        sem.wait();
+    inline auto benchmark_accessor(SpinBarrier& barrier, T& map, const BenchmarkOptions& options, const RunContext& context, uint64_t seed, const std::atomic<bool>& done, std::atomic<uint64_t>& num_accesses, uint64_t num_ids, AccessorState& out_state, PerfTotals& perf, PhaseTimes& times, uint32_t thread) -> void {
+        // Scratch buffers are kept from the slot's previous runs, so they don't have to grow again while timed
+        auto& state = accessor_state();
+        AccessorState fresh{};
+        fresh.buffer = std::move(state.buffer);
+        fresh.fetches = std::move(state.fetches);
+        fresh.batch_keys = std::move(state.batch_keys);
+        fresh.batch_entries = std::move(state.batch_entries);
+        fresh.fetches.clear();
+        fresh.batch_keys.clear();
+        fresh.batch_entries.clear();
+        state = std::move(fresh);
+
+        state.eviction = options.eviction;
+        state.num_samples = options.num_samples;
+        state.num_ids = num_ids;
+        state.rng.seed(~seed);
+        state.ttl = options.ttl;
+        state.ttl_ms = std::max<uint64_t>(options.ttl_ms, 1);
+        state.wheel = context.wheel;
+        state.slab = context.slab;
+        state.backend = context.backend;
+        state.value_min = std::min(options.value_min, options.value_max);
+        state.value_max = options.value_max;
+        state.buffer.resize(options.value_max);
+
+        std::optional<SlabAllocator::ThreadCache> slab_cache;
+        if (context.slab) {
+            slab_cache.emplace(*context.slab);
+        }
+
+        std::optional<ScrambledZipfDistribution> zipf;
+        if (context.zipf) {
+            zipf = *context.zipf;
+        }
+
+        PerfCounters counters;
+        uint64_t num_local_accesses = 0;
+
+        barrier.arrive_and_wait();
+        times.begin(thread);
+        counters.start();
 
         std::mt19937 rng(seed);
         std::uniform_int_distribution<uint32_t> dist(0, num_ids);
 
+        auto batch_size = std::max<uint32_t>(options.batch_size, 1);
+        std::vector<uint64_t> batch(batch_size);
+
         while (!done.load()) {
-            auto index = dist(rng);
+            if (batch_size == 1) {
+                auto index = zipf ? (*zipf)(rng) : dist(rng);
 
-            // Access the cached resource
-            map.access(index);
-            num_accesses.fetch_add(1);
+                // Access the cached resource
+                map.access(index);
+            } else {
+                for (auto& index : batch) {
+                    index = zipf ? (*zipf)(rng) : dist(rng);
+                }
+
+                // Access a whole batch of cached resources, as a multi-get of a single request
+                map.access_batch(Span<const uint64_t>(batch));
+            }
+
+            complete_fetches();
+            num_accesses.fetch_add(batch_size);
+            num_local_accesses += batch_size;
+            times.set_progress(thread, num_local_accesses);
 
             // Sleep for 100 ns
             busy_sleep(10000);
         }
+
+        counters.stop();
+        times.end(thread);
+        perf.add(counters.read(), num_local_accesses);
+
+        out_state = state;
     }
 
     template<typename T>
-    inline auto benchmark_cleaner(Semaphore& sem, T& map, const std::atomic<bool>& done, uint64_t num_ids) -> void {
-        sem.wait();
+    inline auto benchmark_cleaner(SpinBarrier& barrier, T& map, SlabAllocator* slab, const std::atomic<bool>& done, uint64_t first_id, uint64_t last_id) -> void {
+        // Erased values are freed by the cleaner
+        std::optional<SlabAllocator::ThreadCache> slab_cache;
+        if (slab) {
+            slab_cache.emplace(*slab);
+        }
+
+        accessor_state().slab = slab;
+        barrier.arrive_and_wait();
 
         bool cleaning = false;
 
-        for (uint64_t i = 1; !done.load() || cleaning;i = (i + 1) % num_ids) {
+        // Sweep only our own part of the key space [first_id, last_id)
+        for (uint64_t i = first_id; !done.load() || cleaning; i = (i + 1 < last_id) ? i + 1 : first_id) {
             auto size = map.get_size();
             auto capacity = map.get_capacity();
 
@@ -74,45 +501,146 @@ namespace CacheBenchmark {
     }
 
     template<typename T>
-    inline auto benchmark_impl(uint64_t seed, uint64_t time_limit, uint64_t map_capacity, uint32_t num_threads) -> RunResult {
-        T map(map_capacity);
+    inline auto benchmark_expirer(SpinBarrier& barrier, T& map, TimingWheel& wheel, SlabAllocator* slab, const std::atomic<bool>& done, uint64_t& num_expired, uint64_t& expiry_ns) -> void {
+        std::optional<SlabAllocator::ThreadCache> slab_cache;
+        if (slab) {
+            slab_cache.emplace(*slab);
+        }
+
+        accessor_state().slab = slab;
+        barrier.arrive_and_wait();
+
+        while (!done.load()) {
+            auto start = get_timepoint();
+            num_expired += wheel.advance(now_ms(), [&map](uint64_t key) {
+                return map.expire(key);
+            });
+            expiry_ns += get_duration(start, get_timepoint());
+
+            // Wheel granularity is 1 ms
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    template<typename T>
+    inline auto benchmark_impl(const BenchmarkOptions& options, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
+
+        // Values live in a per run slab (released in bulk after the map), capacity is then counted in bytes
+        std::unique_ptr<SlabAllocator> slab;
+        if (options.value_max > 0) {
+            slab = std::make_unique<SlabAllocator>();
+        }
+
+        T map(options.map_capacity, slab ? options.capacity_bytes : options.map_capacity);
         RunResult result{};
 
-        Semaphore sem;
         Timer t;
 
-        auto num_ids = map_capacity + (map_capacity / 5);
+        auto time_limit = options.time_limit;
+        auto num_ids = options.map_capacity + (options.map_capacity / 5);
+
+        // Cleaner threads, sampled eviction doesn't need any
+        uint32_t num_cleaners = 0;
+        if (options.eviction == EvictionPolicy::Cleaner) {
+            num_cleaners = 1;
+        } else if (options.eviction == EvictionPolicy::Partitioned) {
+            num_cleaners = std::max<uint32_t>(options.num_cleaners, 1);
+        }
+
+        // Accessors, helper threads and the main thread all start together
+        auto has_expirer = options.ttl != TTLDistribution::None && options.expiry == ExpiryPolicy::Wheel;
+        SpinBarrier barrier(num_threads + num_cleaners + (has_expirer ? 1 : 0) + 1);
 
-        // Cleaner thread
+        // Cleaners get their own flag, they have to outlive accessors stalled on a full map
         std::atomic<bool> done = false;
-        std::thread cleaner_thread(
-            &benchmark_cleaner<T>,
-            std::ref(sem),
-            std::ref(map),
-            std::cref(done),
-            num_ids
-        );
+        std::atomic<bool> cleaners_done = false;
+        TaskGroup helpers;
+        for (uint32_t i = 0; i < num_cleaners; i++) {
+            // Key 0 is skipped, same as the original single cleaner
+            auto range = (num_ids - 1) / num_cleaners;
+            auto first_id = 1 + i * range;
+            auto last_id = (i == num_cleaners - 1) ? num_ids : (first_id + range);
+
+            // Helper threads are placed behind the accessors
+            helpers.run(
+                num_threads + i,
+                &benchmark_cleaner<T>,
+                std::ref(barrier),
+                std::ref(map),
+                slab.get(),
+                std::cref(cleaners_done),
+                first_id,
+                last_id
+            );
+        }
+
+        // Expirer thread, only needed for active expiry
+        std::unique_ptr<TimingWheel> wheel;
+        uint64_t num_expired_active = 0;
+        uint64_t expiry_ns = 0;
+
+        if (has_expirer) {
+            wheel = std::make_unique<TimingWheel>(now_ms());
+            helpers.run(
+                num_threads + num_cleaners,
+                &benchmark_expirer<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::ref(*wheel),
+                slab.get(),
+                std::cref(cleaners_done),
+                std::ref(num_expired_active),
+                std::ref(expiry_ns)
+            );
+        }
+
+        // Simulated backend and key popularity
+        std::unique_ptr<Backend> backend;
+        if (options.backend_latency_ns > 0) {
+            backend = std::make_unique<Backend>(options.backend_latency_ns, options.backend_wait, options.coalesce);
+        }
+
+        std::unique_ptr<ScrambledZipfDistribution> zipf;
+        if (options.zipf > 0.0) {
+            zipf = std::make_unique<ScrambledZipfDistribution>(num_ids, options.zipf);
+        }
+
+        RunContext context{ wheel.get(), slab.get(), backend.get(), zipf.get() };
 
         // Accessor threads
-        std::vector<std::thread> threads;
+        TaskGroup accessors;
+        std::vector<AccessorState> accessor_states(num_threads);
         std::atomic<uint64_t> num_accesses = 0;
+        PerfTotals perf;
+        PhaseTimes times(num_threads);
         for (int i = 0; i < num_threads; i++) {
-            threads.emplace_back(
-                std::thread(
-                    &benchmark_accessor<T>,
-                    std::ref(sem),
-                    std::ref(map),
-                    seed + i,
-                    std::cref(done),
-                    std::ref(num_accesses),
-                    num_ids
-                )
+            accessors.run(
+                i,
+                &benchmark_accessor<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(options),
+                std::cref(context),
+                options.seed + i,
+                std::cref(done),
+                std::ref(num_accesses),
+                num_ids,
+                std::ref(accessor_states[i]),
+                std::ref(perf),
+                std::ref(times),
+                i
             );
         }
 
+        barrier.arrive_and_wait();
+        t.start_at(barrier.get_release_timepoint());
+
+        ThroughputSampler sampler(times);
+        sampler.start(t.get_start());
+
         auto start = std::chrono::high_resolution_clock::now();
         auto end = start + std::chrono::milliseconds(time_limit);
-        sem.notify_all();
 
         while (true) {
             auto current = std::chrono::high_resolution_clock::now();
@@ -135,53 +663,108 @@ namespace CacheBenchmark {
 
         done.store(true);
 
-        // Clean up threads
-        for (auto& th : threads) {
-            th.join();
-        }
+        // Wait for the accessors
+        accessors.wait();
+        t.end();
+        sampler.stop();
 
-        cleaner_thread.join();
+        times.report(result, "access", t);
+        sampler.report(result, "access");
+        result.metrics["ops_per_sec"] = t.get_duration() > 0 ? result.value * 1e9 / t.get_duration() : 0.0;
 
-        return result;
-    }
+        cleaners_done.store(true);
+        helpers.wait();
 
-    template<typename T>
-    inline auto run_benchmark(const std::string& impl, uint64_t seed, uint64_t time_limit, uint64_t map_capacity, uint32_t num_runs, uint32_t num_threads) -> BenchmarkResult {
-        BenchmarkResult result{};
+        // Tables replaced while growing, no accessor probes them anymore
+        reclaim_map(map);
 
-        result.value_unit = "";
-        result.impl = impl;
-        result.correct = true;
-        result.num_runs = num_runs;
-        result.num_threads = num_threads;
+        // Map and value memory, the map is at capacity for most of the run. The slabs don't go through the counting
+        // allocator, they're added so the counted maps include the values like Junction's RSS growth does
+        if (slab) {
+            memory.add_untracked(slab->get_stats().slab_bytes);
+        }
 
-        result.total_value = 0;
-        result.min_value = std::numeric_limits<uint64_t>::max();
-        result.max_value = std::numeric_limits<uint64_t>::min();
+        memory.finish();
+        report_memory(result, memory, map.get_num_entries());
+
+        introspect_map(map, result);
+
+        // Backpressure, time accessors spent waiting for (or making) free space
+        uint64_t stall_ns = 0;
+        uint64_t num_stalls = 0;
+        uint64_t num_evictions = 0;
+        uint64_t num_expired_lazy = 0;
+        uint64_t backend_ns = 0;
+        for (auto& state : accessor_states) {
+            backend_ns += state.backend_ns;
+            stall_ns += state.stall_ns;
+            num_stalls += state.num_stalls;
+            num_evictions += state.num_evictions;
+            num_expired_lazy += state.num_expired;
+        }
 
-        result.hash = 0;
+        auto accessor_ns = static_cast<double>(time_limit) * 1e6 * num_threads;
 
-        for (uint32_t i = 0; i < num_runs; i++) {
-            std::cout << "Starting iteration " << (i + 1) << "/" << num_runs << std::endl;
-            auto run_result = benchmark_impl<T>(seed, time_limit, map_capacity, num_threads);
+        result.metrics["stall_ns"] = stall_ns;
+        result.metrics["stall_ratio"] = accessor_ns > 0 ? stall_ns / accessor_ns : 0.0;
+        result.metrics["num_stalls"] = num_stalls;
+        result.metrics["num_evictions"] = num_evictions;
+        result.metrics["batch_size"] = std::max<uint32_t>(options.batch_size, 1);
 
-            if (i == 0) {
-                result.hash = run_result.hash;
-            }
+        // Accessors only, an operation is a single key access
+        perf.report(result);
 
-            if (run_result.hash != result.hash) {
-                result.correct = false;
-            }
+        // Expiry, lazily renewed entries and the cost of the expirer thread
+        result.metrics["num_expired_lazy"] = num_expired_lazy;
+        result.metrics["num_expired_active"] = num_expired_active;
+        result.metrics["expiry_ns"] = expiry_ns;
+
+        std::cout << "Stalled: " << (stall_ns / 1000000) << "ms total, " << num_stalls << " stalls, " << num_evictions << " inline evictions" << std::endl;
 
-            result.runs.push_back(run_result);          
-            result.total_value += run_result.value;
+        // Backend, calls saved by coalescing and time spent fetching (or waiting for a fetch)
+        if (backend) {
+            result.metrics["backend_calls"] = backend->get_num_calls();
+            result.metrics["backend_coalesced"] = backend->get_num_coalesced();
+            result.metrics["backend_ns"] = backend_ns;
 
-            result.min_value = std::min(result.min_value, run_result.value);
-            result.max_value = std::max(result.max_value, run_result.value);
+            std::cout << "Backend: " << backend->get_num_calls() << " calls, " << backend->get_num_coalesced() << " coalesced" << std::endl;
         }
 
-        result.avg_value = result.total_value / result.num_runs;
-        result.mean_value = result.runs[result.num_runs / 2].value;
+        // Memory, only meaningful with values
+        if (slab) {
+            auto stats = slab->get_stats();
+            auto rss = get_rss();
+            auto value_bytes = stats.requested_bytes - stats.num_allocations * sizeof(Payload);
+
+            result.metrics["value_bytes"] = value_bytes;
+            result.metrics["chunk_bytes"] = stats.chunk_bytes;
+            result.metrics["slab_bytes"] = stats.slab_bytes;
+            result.metrics["rss_bytes"] = rss;
+            result.metrics["memory_efficiency"] = rss > 0 ? static_cast<double>(value_bytes) / rss : 0.0;
+            result.metrics["internal_fragmentation"] = stats.chunk_bytes > 0 ? 1.0 - static_cast<double>(stats.requested_bytes) / stats.chunk_bytes : 0.0;
+            result.metrics["external_fragmentation"] = stats.slab_bytes > 0 ? 1.0 - static_cast<double>(stats.chunk_bytes) / stats.slab_bytes : 0.0;
+
+            std::cout << "Memory: " << (value_bytes / 1024) << "KiB of values, " << (stats.slab_bytes / 1024) << "KiB of slabs, " << (rss / 1024) << "KiB RSS" << std::endl;
+        }
+
+        if (options.ttl != TTLDistribution::None) {
+            std::cout << "Expired: " << num_expired_lazy << " on read, " << num_expired_active << " by the expirer (" << (expiry_ns / 1000000) << "ms)" << std::endl;
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    inline auto run_benchmark(const std::string& impl, const BenchmarkOptions& options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
+        BenchmarkResult result{};
+
+        result.impl = impl;
+        result.value_unit = "";
+        result.num_threads = num_threads;
+
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(options, num_threads);
+        });
 
         return result;
     }
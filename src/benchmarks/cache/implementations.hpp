@@ -0,0 +1,62 @@
+#pragma once
+#include "libcuckoo.hpp"
+#include "stdmap.hpp"
+#include "tbbmap.hpp"
+#include "junction.hpp"
+#include "swiss.hpp"
+#include "../registry.hpp"
+
+namespace CacheBenchmark {
+    // Implementations selectable with --implementation, in the order "all" runs them
+    struct CuckooImpl {
+        using Map = CuckooMap;
+        static constexpr const char* name = "libcuckoo";
+        static constexpr const char* description = "libcuckoo";
+    };
+
+    struct TBBHashImpl {
+        using Map = TBBHashMap;
+        static constexpr const char* name = "tbb-hash";
+        static constexpr const char* description = "TBB concurrent_hash_map";
+    };
+
+    struct STDBlockingImpl {
+        using Map = STDMap;
+        static constexpr const char* name = "std-blocking";
+        static constexpr const char* description = "Blocking STD";
+    };
+
+    struct STDSeqlockImpl {
+        using Map = STDSeqlockMap;
+        static constexpr const char* name = "std-seqlock";
+        static constexpr const char* description = "STD style chained buckets + per bucket seqlocks";
+    };
+
+    struct JunctionGrampaImpl {
+        using Map = JunctionMapGrampa;
+        static constexpr const char* name = "junction-grampa";
+        static constexpr const char* description = "Junction ConcurrentMap_Grampa";
+    };
+
+    struct JunctionLeapfrogImpl {
+        using Map = JunctionMapLeapfrog;
+        static constexpr const char* name = "junction-leapfrog";
+        static constexpr const char* description = "Junction ConcurrentMap_Leapfrog";
+    };
+
+    struct SwissImpl {
+        using Map = SwissMap;
+        static constexpr const char* name = "swiss";
+        static constexpr const char* description = "Concurrent Swiss table (SSE2 groups, seqlock reads)";
+    };
+
+    using Implementations = Registry<
+        CuckooImpl,
+        TBBHashImpl,
+        STDBlockingImpl,
+        STDSeqlockImpl,
+        JunctionGrampaImpl,
+        JunctionLeapfrogImpl,
+        SwissImpl
+    >;
+}
@@ -23,7 +23,7 @@ namespace CacheBenchmark {
     class JunctionMap {
         public:
             // It's never mentioned anywhere, but leapfrogs size needs to be a power of 2
-            JunctionMap(uint64_t capacity) : capacity(capacity), size(0), map(nearest_power_of_2(capacity)) {
+            JunctionMap(uint64_t num_entries, uint64_t capacity) : map(nearest_power_of_2(num_entries)), capacity(capacity), size(0) {
             }
 
             auto access(uint64_t key) -> CacheData {
@@ -33,48 +33,155 @@ namespace CacheBenchmark {
                 auto mutator = this->map.find(key + 1);
                 auto value = mutator.getValue();
 
-                if (value == 0) {
-                    auto size = this->get_size();
-                    auto capacity = this->get_capacity();
+                if (value != 0) {
+                    auto entry = unpack(key, value);
 
-                    // Wait while we have less than 2% of free space
-                    while (size > capacity - (capacity / 50)) {
-                        size = this->get_size();
+                    if (!is_expired(entry)) {
+                        read_entry(entry);
+                        return entry;
                     }
+                } else {
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
+                }
 
-                    auto mutator = this->map.insertOrFind(key + 1);
-
-                    // Junction needs the values 0 (Default) and 1(Redirect) for it's own purposes
-                    // so we modify the value by 2
-                    auto old_value = mutator.exchangeValue(value + 2);
-                    if (old_value == 0)
-                        this->size.fetch_add(1);
+                auto entry = make_entry(key);
+                auto old_value = this->map.insertOrFind(key + 1).exchangeValue(pack(entry));
+                schedule_entry(entry);
 
-                    return key;
+                if (old_value == 0) {
+                    this->size.fetch_add(entry_charge(entry));
                 } else {
-                    return value - 2;
+                    // Replaced an expired entry (or one inserted in the meantime)
+                    auto old_entry = unpack(key, old_value);
+                    this->size.fetch_add(entry_charge(entry) - entry_charge(old_entry));
+                    release_entry(old_entry);
+
+                    if (value != 0)
+                        accessor_state().num_expired++;
                 }
+
+                return entry;
+            }
+
+            // Junction is lock free, batching only moves the fetches out of the lookup loop
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.clear();
+
+                for (auto key : keys) {
+                    auto value = this->map.get(key + 1);
+
+                    if (value != 0) {
+                        auto entry = unpack(key, value);
+
+                        if (!is_expired(entry)) {
+                            read_entry(entry);
+                            continue;
+                        }
+                    }
+
+                    misses.push_back(key);
+                }
+
+                if (misses.empty())
+                    return;
+
+                for (auto& entry : prepare_entries(*this, misses)) {
+                    auto old_value = this->map.insertOrFind(entry.value + 1).exchangeValue(pack(entry));
+                    schedule_entry(entry);
+
+                    if (old_value == 0) {
+                        this->size.fetch_add(entry_charge(entry));
+                    } else {
+                        auto old_entry = unpack(entry.value, old_value);
+                        this->size.fetch_add(entry_charge(entry) - entry_charge(old_entry));
+                        release_entry(old_entry);
+
+                        if (is_expired(old_entry))
+                            accessor_state().num_expired++;
+                    }
+                }
+            }
+
+            auto erase(uint64_t key) -> bool {
+                // Erase returns the old value, 0 (NullValue) means the key wasn't present
+                auto value = this->map.erase(key + 1);
+                if (value == 0)
+                    return false;
+
+                this->remove(unpack(key, value));
+                return true;
             }
 
-            auto erase(uint64_t key) -> void {
-                if (this->map.erase(key + 1) == 0)
-                    this->size.fetch_sub(1);
+            auto expire(uint64_t key) -> bool {
+                auto mutator = this->map.find(key + 1);
+                auto value = mutator.getValue();
+
+                if (value == 0 || !is_expired(unpack(key, value)))
+                    return false;
+
+                // There is no conditional erase, an entry renewed in between gets erased as well
+                value = mutator.eraseValue();
+                if (value == 0)
+                    return false;
+
+                this->remove(unpack(key, value));
+                return true;
             }
 
             auto get_size() const -> uint64_t {
                 return this->size.load();
             }
 
+            // Junction doesn't keep a count, only call this while no one else is using the map
+            auto get_num_entries() -> uint64_t {
+                uint64_t num_entries = 0;
+
+                for (typename MapType::Iterator iter(this->map); iter.isValid(); iter.next()) {
+                    num_entries++;
+                }
+
+                return num_entries;
+            }
+
             auto get_capacity() const -> uint64_t {
                 return this->capacity;
             }
 
+            // Junction doesn't expose its cells
+            auto introspect(MapStats&) -> void {
+            }
+
         private:
+            // Junction can only hold a single integer. Without values, the value is always the key itself,
+            // so only the deadline gets stored, tagged by the lowest 2 bits (values 0 (Default) and 1 (Redirect)
+            // are reserved by Junction). With values we store the (16 byte aligned) payload, which has a copy of the deadline.
+            static auto pack(const CacheData& entry) -> uint64_t {
+                if (entry.payload)
+                    return reinterpret_cast<uint64_t>(entry.payload);
+
+                return (entry.expires_at << 2) | 2;
+            }
+
+            static auto unpack(uint64_t key, uint64_t value) -> CacheData {
+                if ((value & 3) == 2)
+                    return CacheData{ key, value >> 2, nullptr };
+
+                auto payload = reinterpret_cast<Payload*>(value);
+                return CacheData{ key, payload->expires_at, payload };
+            }
+
+            auto remove(const CacheData& entry) -> void {
+                this->size.fetch_sub(entry_charge(entry));
+                release_entry(entry);
+            }
+
             MapType map;
             uint64_t capacity;
             std::atomic<uint64_t> size;
     };
 
-    using JunctionMapGrampa = JunctionMap<junction::ConcurrentMap_Grampa<uint64_t, CacheData>>;
-    using JunctionMapLeapfrog = JunctionMap<junction::ConcurrentMap_Leapfrog<uint64_t, CacheData>>;
+    using JunctionMapGrampa = JunctionMap<junction::ConcurrentMap_Grampa<uint64_t, uint64_t>>;
+    using JunctionMapLeapfrog = JunctionMap<junction::ConcurrentMap_Leapfrog<uint64_t, uint64_t>>;
 }
\ No newline at end of file
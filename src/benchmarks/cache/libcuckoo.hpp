@@ -6,46 +6,151 @@
 namespace CacheBenchmark {
     class CuckooMap {
         public:
-            CuckooMap(uint64_t capacity) : capacity(capacity), size(0) {
-                this->map.reserve(capacity);
+            CuckooMap(uint64_t num_entries, uint64_t capacity) : capacity(capacity), size(0) {
+                this->map.reserve(num_entries);
             }
 
             auto access(uint64_t key) -> CacheData {
                 CacheData result{};
 
-                if (this->map.find(key, result)) {
+                // Values are read under the bucket lock
+                if (this->map.find_fn(key, [&](const CacheData& value) {
+                    result = value;
+                    if (!is_expired(value))
+                        read_entry(value);
+                }) && !is_expired(result)) {
                     return result;
                 } else {
-                    auto size = this->get_size();
-                    auto capacity = this->get_capacity();
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
 
-                    // Wait while we have less than 2% of free space
-                    while (size > capacity - (capacity / 50)) {
-                        size = this->get_size();
-                    }
+                    // Insert, or renew the entry in case it has expired
+                    auto entry = make_entry(key);
+                    bool used = false;
+                    uint64_t charge = entry_charge(entry);
+
+                    auto inserted = this->map.upsert(key, [&](CacheData& value) {
+                        if (is_expired(value)) {
+                            charge = renew_entry(value, entry);
+                            used = true;
+                        }
+                    }, entry);
 
-                    if (this->map.insert(key, key))
-                        this->size.fetch_add(1);
+                    if (inserted || used) {
+                        this->size.fetch_add(charge);
+                        schedule_entry(entry);
+                    } else {
+                        // Someone else was faster
+                        release_entry(entry);
+                    }
                     
-                    return key;
+                    return entry;
                 }
             }
 
-            auto erase(uint64_t key) -> void {
-                if (this->map.erase(key))
-                    this->size.fetch_sub(1);
+            // Libcuckoo doesn't expose it's bucket locks, keys are instead visited in bucket order,
+            // so keys sharing a bucket (and lock) are looked up back to back
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.assign(keys.begin(), keys.end());
+
+                auto hasher = this->map.hash_function();
+                auto mask = this->map.bucket_count() - 1;
+                std::sort(misses.begin(), misses.end(), [&](uint64_t a, uint64_t b) {
+                    return (hasher(a) & mask) < (hasher(b) & mask);
+                });
+
+                // Hits are removed from the list, leaving only the misses
+                misses.erase(std::remove_if(misses.begin(), misses.end(), [&](uint64_t key) {
+                    bool hit = false;
+
+                    this->map.find_fn(key, [&](const CacheData& value) {
+                        hit = !is_expired(value);
+                        if (hit)
+                            read_entry(value);
+                    });
+
+                    return hit;
+                }), misses.end());
+
+                if (misses.empty())
+                    return;
+
+                for (auto& entry : prepare_entries(*this, misses)) {
+                    bool used = false;
+                    uint64_t charge = entry_charge(entry);
+
+                    auto inserted = this->map.upsert(entry.value, [&](CacheData& value) {
+                        if (is_expired(value)) {
+                            charge = renew_entry(value, entry);
+                            used = true;
+                        }
+                    }, entry);
+
+                    if (inserted || used) {
+                        this->size.fetch_add(charge);
+                        schedule_entry(entry);
+                    } else {
+                        release_entry(entry);
+                    }
+                }
+            }
+
+            auto erase(uint64_t key) -> bool {
+                uint64_t charge = 0;
+
+                // Always erases, the value is released under the bucket lock
+                auto found = this->map.erase_fn(key, [&](CacheData& value) {
+                    charge = entry_charge(value);
+                    release_entry(value);
+                    return true;
+                });
+
+                if (!found)
+                    return false;
+
+                this->size.fetch_sub(charge);
+                return true;
+            }
+
+            auto expire(uint64_t key) -> bool {
+                bool erased = false;
+                uint64_t charge = 0;
+
+                this->map.erase_fn(key, [&](CacheData& value) {
+                    erased = is_expired(value);
+                    if (erased) {
+                        charge = entry_charge(value);
+                        release_entry(value);
+                    }
+
+                    return erased;
+                });
+
+                if (erased)
+                    this->size.fetch_sub(charge);
+
+                return erased;
             }
 
             auto get_size() const -> uint64_t {
                 return this->size.load();
             }
 
+            auto get_num_entries() const -> uint64_t {
+                return this->map.size();
+            }
+
             auto get_capacity() const -> uint64_t {
                 return this->capacity;
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            libcuckoo::cuckoohash_map<uint64_t, CacheData> map;
+            libcuckoo::cuckoohash_map<uint64_t, CacheData, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, CacheData>> map;
 
             uint64_t capacity;
             std::atomic<uint64_t> size;
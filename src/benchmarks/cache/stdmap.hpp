@@ -5,12 +5,13 @@
 #include <chrono>
 #include <atomic>
 #include "cache.hpp"
+#include "../../utils/seqlock.hpp"
 
 namespace CacheBenchmark {
     class STDMap {
         public:
-            STDMap(uint64_t capacity) : capacity(capacity), size(0) {
-                this->map.reserve(capacity);
+            STDMap(uint64_t num_entries, uint64_t capacity) : size(0), capacity(capacity) {
+                this->map.reserve(num_entries);
             }
 
             auto access(uint64_t key) -> CacheData {
@@ -18,53 +19,372 @@ namespace CacheBenchmark {
                 {
                     std::shared_lock lock(this->mtx);
                     auto res = this->map.find(key);
-                    if (res != this->map.end()) {
+                    if (res != this->map.end() && !is_expired(res->second)) {
+                        read_entry(res->second);
                         return res->second;
                     }
                 }
                 
                 {
-                    auto size = this->get_size();
-                    auto capacity = this->get_capacity();
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
 
-                    // Wait while we have less than 2% of free space
-                    while (size > capacity - (capacity / 50)) {
-                        size = this->get_size();
+                    // Prepare the entry outside of the lock
+                    auto entry = make_entry(key);
+                    bool used = true;
+
+                    // No (valid) value found, bring out the exclusive lock
+                    {
+                        std::unique_lock lock(this->mtx);
+                        auto result = this->map.try_emplace(key, entry);
+
+                        if (result.second) {
+                            this->size.fetch_add(entry_charge(entry));
+                        } else if (is_expired(result.first->second)) {
+                            this->size.fetch_add(renew_entry(result.first->second, entry));
+                        } else {
+                            used = false;
+                        }
+                    }
+
+                    // Someone else was faster
+                    if (used) {
+                        schedule_entry(entry);
+                    } else {
+                        release_entry(entry);
                     }
 
-                    // No value found, bring out the exclusive lock
+                    return entry;
+                }
+            }
+
+            // Takes the shared lock once for all lookups and the exclusive lock once for all inserts
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.clear();
+
+                {
+                    std::shared_lock lock(this->mtx);
+
+                    for (auto key : keys) {
+                        auto res = this->map.find(key);
+                        if (res != this->map.end() && !is_expired(res->second)) {
+                            read_entry(res->second);
+                        } else {
+                            misses.push_back(key);
+                        }
+                    }
+                }
+
+                if (misses.empty())
+                    return;
+
+                auto& entries = prepare_entries(*this, misses);
+
+                {
                     std::unique_lock lock(this->mtx);
-                    auto result = this->map.emplace(
-                        key,
-                        key
-                    );
 
-                    if (result.second)
-                        this->size.fetch_add(1);
+                    for (auto& entry : entries) {
+                        auto result = this->map.try_emplace(entry.value, entry);
 
-                    return result.first->second;
+                        if (result.second) {
+                            this->size.fetch_add(entry_charge(entry));
+                            schedule_entry(entry);
+                        } else if (is_expired(result.first->second)) {
+                            this->size.fetch_add(renew_entry(result.first->second, entry));
+                            schedule_entry(entry);
+                        } else {
+                            // Someone else was faster
+                            release_entry(entry);
+                        }
+                    }
                 }
             }
 
-            auto erase(uint64_t key) -> void {
+            auto erase(uint64_t key) -> bool {
+                std::unique_lock lock(this->mtx);
+                auto res = this->map.find(key);
+                if (res == this->map.end())
+                    return false;
+
+                this->remove(res);
+                return true;
+            }
+
+            auto expire(uint64_t key) -> bool {
                 std::unique_lock lock(this->mtx);
-                if (this->map.erase(key) > 0)
-                    this->size.fetch_sub(1);
+                auto res = this->map.find(key);
+                if (res == this->map.end() || !is_expired(res->second))
+                    return false;
+
+                this->remove(res);
+                return true;
             }
 
             auto get_size() const -> uint64_t {
                 return this->size.load();
             }
 
+            auto get_num_entries() -> uint64_t {
+                std::shared_lock lock(this->mtx);
+                return this->map.size();
+            }
+
             auto get_capacity() const -> uint64_t {
                 return this->capacity;
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
+            using MapType = std::unordered_map<uint64_t, CacheData, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, CacheData>>;
+
+            // Exclusive lock has to be held
+            auto remove(MapType::iterator it) -> void {
+                this->size.fetch_sub(entry_charge(it->second));
+                release_entry(it->second);
+                this->map.erase(it);
+            }
+
             std::shared_mutex mtx{};
-            std::unordered_map<uint64_t, CacheData> map{};
+            MapType map{};
+
+            std::atomic<uint64_t> size;
+            uint64_t capacity;
+    };
+
+    // Read optimized variant of STDMap, laid out like std::unordered_map (a bucket array with a chain of nodes each)
+    // but the bucket array never changes and every bucket has a seqlock. Hits walk the chain and copy the entry without
+    // writing shared memory, and retry when the bucket changed in between. Writes and erases lock only their bucket.
+    // Unlinked nodes go onto their bucket's free list instead of being freed, so a reader still walking one reads stale
+    // but mapped memory (and then retries), they're only freed with the map.
+    class STDSeqlockMap {
+        public:
+            STDSeqlockMap(uint64_t num_entries, uint64_t capacity) : buckets(bucket_count_for(num_entries)), size(0), num_entries(0), capacity(capacity) {
+            }
+
+            ~STDSeqlockMap() {
+                for (auto& bucket : this->buckets) {
+                    for (auto list : { bucket.head, bucket.free }) {
+                        while (list != nullptr) {
+                            auto next = list->next;
+                            NodeAllocator{}.deallocate(list, 1);
+                            list = next;
+                        }
+                    }
+                }
+            }
+
+            auto access(uint64_t key) -> CacheData {
+                CacheData entry{};
+                auto found = this->find(key, entry);
+
+                if (found && !is_expired(entry)) {
+                    read_entry(entry);
+                    return entry;
+                }
+
+                if (!found) {
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
+                }
+
+                auto fresh = make_entry(key);
+                this->insert(fresh);
+                return fresh;
+            }
+
+            // Lookups take no lock anyway, batching only moves the fetches out of the lookup loop
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.clear();
+
+                for (auto key : keys) {
+                    CacheData entry{};
+                    if (this->find(key, entry) && !is_expired(entry)) {
+                        read_entry(entry);
+                    } else {
+                        misses.push_back(key);
+                    }
+                }
+
+                if (misses.empty())
+                    return;
+
+                for (auto& entry : prepare_entries(*this, misses)) {
+                    this->insert(entry);
+                }
+            }
+
+            auto erase(uint64_t key) -> bool {
+                return this->remove_if(key, [](const CacheData&) { return true; });
+            }
+
+            auto expire(uint64_t key) -> bool {
+                return this->remove_if(key, [](const CacheData& entry) { return is_expired(entry); });
+            }
+
+            auto get_size() const -> uint64_t {
+                return this->size.load();
+            }
+
+            auto get_num_entries() -> uint64_t {
+                return this->num_entries.load();
+            }
+
+            auto get_capacity() const -> uint64_t {
+                return this->capacity;
+            }
+
+            // Chains are walked without the bucket locks, only while no one else is using the map
+            auto introspect(MapStats& stats) -> void {
+                for (auto& bucket : this->buckets) {
+                    uint64_t length = 0;
+                    for (auto node = bucket.head; node != nullptr; node = node->next) {
+                        length++;
+                    }
+
+                    stats.add_chain(length);
+                }
+            }
+
+        private:
+            struct Node {
+                Node* next;
+                CacheData entry;
+            };
+
+            struct Bucket {
+                SeqlockVersion version;
+                Node* head = nullptr;
+                Node* free = nullptr;          // Only touched with the bucket locked
+            };
+
+            using NodeAllocator = CountingAllocator<Node>;
+
+            // Readers walking a chain check the version every few nodes, a node reused meanwhile could lead them in circles
+            static constexpr uint32_t CHECK_INTERVAL = 16;
+
+            // Load factor 1 like std::unordered_map, a power of 2
+            static auto bucket_count_for(uint64_t num_entries) -> uint64_t {
+                uint64_t count = 1;
+                while (count < num_entries) {
+                    count *= 2;
+                }
+
+                return count;
+            }
+
+            auto bucket_of(uint64_t key) -> Bucket& {
+                return this->buckets[(key * 0x9E3779B97F4A7C15ull >> 32) & (this->buckets.size() - 1)];
+            }
+
+            auto find(uint64_t key, CacheData& entry) -> bool {
+                auto& bucket = this->bucket_of(key);
+
+                while (true) {
+                    auto version = bucket.version.read_begin();
+                    auto node = bucket.head;
+                    bool found = false;
+                    bool changed = false;
+                    uint32_t steps = 0;
+
+                    // Nodes may be unlinked (and reused) while we walk them, everything read is validated by the version
+                    while (node != nullptr && !found) {
+                        if (++steps % CHECK_INTERVAL == 0 && bucket.version.read_retry(version)) {
+                            changed = true;
+                            break;
+                        }
+
+                        Node copy;
+                        std::memcpy(&copy, node, sizeof(Node));
+
+                        if (copy.entry.value == key) {
+                            entry = copy.entry;
+                            found = true;
+                        }
+
+                        node = copy.next;
+                    }
+
+                    if (!changed && !bucket.version.read_retry(version)) {
+                        return found;
+                    }
+                }
+            }
+
+            // Inserts the entry, or renews an expired one in place. Someone else being faster releases the entry
+            auto insert(const CacheData& entry) -> void {
+                auto& bucket = this->bucket_of(entry.value);
+                auto version = bucket.version.lock();
+
+                for (auto node = bucket.head; node != nullptr; node = node->next) {
+                    if (node->entry.value != entry.value)
+                        continue;
+
+                    if (is_expired(node->entry)) {
+                        this->size.fetch_add(renew_entry(node->entry, entry));
+                        bucket.version.unlock(version);
+                        schedule_entry(entry);
+                    } else {
+                        bucket.version.unlock(version);
+                        release_entry(entry);
+                    }
+
+                    return;
+                }
+
+                auto node = bucket.free;
+                if (node != nullptr) {
+                    bucket.free = node->next;
+                } else {
+                    node = NodeAllocator{}.allocate(1);
+                }
+
+                *node = Node{ bucket.head, entry };
+                bucket.head = node;
+                bucket.version.unlock(version);
+
+                this->size.fetch_add(entry_charge(entry));
+                this->num_entries.fetch_add(1);
+                schedule_entry(entry);
+            }
+
+            template<typename F>
+            auto remove_if(uint64_t key, F&& pred) -> bool {
+                auto& bucket = this->bucket_of(key);
+                auto version = bucket.version.lock();
+
+                for (auto link = &bucket.head; *link != nullptr; link = &(*link)->next) {
+                    auto node = *link;
+                    if (node->entry.value != key)
+                        continue;
+
+                    if (!pred(node->entry))
+                        break;
+
+                    auto entry = node->entry;
+                    *link = node->next;
+                    node->next = bucket.free;
+                    bucket.free = node;
+                    bucket.version.unlock(version);
+
+                    this->size.fetch_sub(entry_charge(entry));
+                    this->num_entries.fetch_sub(1);
+                    release_entry(entry);
+                    return true;
+                }
+
+                bucket.version.unlock(version);
+                return false;
+            }
+
+            std::vector<Bucket, CountingAllocator<Bucket>> buckets;
 
             std::atomic<uint64_t> size;
+            std::atomic<uint64_t> num_entries;
             uint64_t capacity;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include "cache.hpp"
+#include "../../utils/swiss_map.hpp"
+
+namespace CacheBenchmark {
+    // Hits are optimistic seqlock reads, no lock and no write to shared memory. Misses take the key's stripe lock.
+    class SwissMap {
+        public:
+            SwissMap(uint64_t num_entries, uint64_t capacity) : map(num_entries), capacity(capacity), size(0) {
+            }
+
+            auto access(uint64_t key) -> CacheData {
+                CacheData entry{};
+                auto found = this->map.find(key, entry);
+
+                if (found && !is_expired(entry)) {
+                    read_entry(entry);
+                    return entry;
+                }
+
+                if (!found) {
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
+                }
+
+                auto fresh = make_entry(key);
+                this->insert(fresh);
+                return fresh;
+            }
+
+            // Lookups are lock free anyway, batching only moves the fetches out of the lookup loop
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.clear();
+
+                for (auto key : keys) {
+                    CacheData entry{};
+                    if (this->map.find(key, entry) && !is_expired(entry)) {
+                        read_entry(entry);
+                    } else {
+                        misses.push_back(key);
+                    }
+                }
+
+                if (misses.empty())
+                    return;
+
+                for (auto& entry : prepare_entries(*this, misses)) {
+                    this->insert(entry);
+                }
+            }
+
+            auto erase(uint64_t key) -> bool {
+                CacheData entry{};
+                if (!this->map.erase(key, entry))
+                    return false;
+
+                this->remove(entry);
+                return true;
+            }
+
+            auto expire(uint64_t key) -> bool {
+                CacheData entry{};
+                if (!this->map.erase_if(key, [](const CacheData& entry) { return is_expired(entry); }, entry))
+                    return false;
+
+                this->remove(entry);
+                return true;
+            }
+
+            auto get_size() const -> uint64_t {
+                return this->size.load();
+            }
+
+            auto get_num_entries() -> uint64_t {
+                return this->map.get_size();
+            }
+
+            auto get_capacity() const -> uint64_t {
+                return this->capacity;
+            }
+
+            // Only between phases
+            auto reclaim() -> void {
+                this->map.reclaim();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            // Inserts the entry, or renews an expired one in place. Returns false if someone else was faster
+            auto insert(const CacheData& entry) -> bool {
+                bool used = true;
+
+                auto inserted = this->map.insert_or_modify(entry.value, entry, [&](CacheData& existing) {
+                    if (is_expired(existing)) {
+                        this->size.fetch_add(renew_entry(existing, entry));
+                    } else {
+                        used = false;
+                    }
+                });
+
+                if (inserted) {
+                    this->size.fetch_add(entry_charge(entry));
+                }
+
+                if (used) {
+                    schedule_entry(entry);
+                } else {
+                    release_entry(entry);
+                }
+
+                return used;
+            }
+
+            auto remove(const CacheData& entry) -> void {
+                this->size.fetch_sub(entry_charge(entry));
+                release_entry(entry);
+            }
+
+            ConcurrentSwissMap<uint64_t, CacheData> map;
+            uint64_t capacity;
+            std::atomic<uint64_t> size;
+    };
+}
@@ -7,44 +7,118 @@
 namespace CacheBenchmark {
     class TBBHashMap {
         public:
-            TBBHashMap(uint64_t capacity) : capacity(capacity), size(0) {
+            TBBHashMap(uint64_t num_entries, uint64_t capacity) : capacity(capacity), size(0) {
                 // We can't use reserve on concurrent_hash_map as it's inherited as protected
             }
 
             auto access(uint64_t key) -> CacheData {
                 MapType::accessor accessor;
-                if (this->map.find(accessor, key)) {
+                if (this->map.find(accessor, key) && !is_expired(accessor->second)) {
+                    read_entry(accessor->second);
                     return accessor->second;
+                }
+
+                // Never hold the lock while fetching a new entry, the fetch could be waiting for us
+                auto expired = !accessor.empty();
+                accessor.release();
+
+                if (!expired) {
+                    // Wait (or evict) while we have less than 2% of free space
+                    make_space(*this);
+                }
+
+                auto entry = make_entry(key);
+                if (map.emplace(accessor, key, entry)) {
+                    this->size.fetch_add(entry_charge(entry));
+                    schedule_entry(entry);
+                } else if (is_expired(accessor->second)) {
+                    // Accessor holds a write lock, an expired entry can be renewed in place
+                    this->size.fetch_add(renew_entry(accessor->second, entry));
+                    schedule_entry(entry);
                 } else {
-                    auto size = this->get_size();
-                    auto capacity = this->get_capacity();
+                    // Someone else was faster
+                    release_entry(entry);
+                }
 
-                    // Wait while we have less than 2% of free space
-                    while (size > capacity - (capacity / 50))
-                        size = this->get_size();
+                return accessor->second;
+            }
+
+            // TBB hides it's buckets, every key still needs it's own accessor.
+            // Reads take read locks (const_accessor) and no write lock is held while the misses are fetched.
+            auto access_batch(Span<const uint64_t> keys) -> void {
+                auto& misses = accessor_state().batch_keys;
+                misses.clear();
+
+                for (auto key : keys) {
+                    MapType::const_accessor accessor;
+                    if (this->map.find(accessor, key) && !is_expired(accessor->second)) {
+                        read_entry(accessor->second);
+                    } else {
+                        misses.push_back(key);
+                    }
+                }
+
+                if (misses.empty())
+                    return;
 
-                    if (map.emplace(accessor, key, key))
-                        this->size.fetch_add(1);
+                for (auto& entry : prepare_entries(*this, misses)) {
+                    MapType::accessor accessor;
 
-                    return key;
+                    if (map.emplace(accessor, entry.value, entry)) {
+                        this->size.fetch_add(entry_charge(entry));
+                        schedule_entry(entry);
+                    } else if (is_expired(accessor->second)) {
+                        this->size.fetch_add(renew_entry(accessor->second, entry));
+                        schedule_entry(entry);
+                    } else {
+                        release_entry(entry);
+                    }
                 }
             }
 
-            auto erase(uint64_t key) -> void {
-                if (this->map.erase(key))
-                    this->size.fetch_sub(1);
+            auto erase(uint64_t key) -> bool {
+                MapType::accessor accessor;
+                if (!this->map.find(accessor, key))
+                    return false;
+
+                this->remove(accessor);
+                return true;
+            }
+
+            auto expire(uint64_t key) -> bool {
+                MapType::accessor accessor;
+                if (!this->map.find(accessor, key) || !is_expired(accessor->second))
+                    return false;
+
+                this->remove(accessor);
+                return true;
             }
 
             auto get_size() const -> uint64_t {
                 return this->size.load();
             }
 
+            auto get_num_entries() const -> uint64_t {
+                return this->map.size();
+            }
+
             auto get_capacity() const -> uint64_t {
                 return this->capacity;
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            using MapType = tbb::concurrent_hash_map<uint64_t, CacheData>;
+            using MapType = tbb::concurrent_hash_map<uint64_t, CacheData, tbb::tbb_hash_compare<uint64_t>, MapAllocator<uint64_t, CacheData>>;
+
+            auto remove(MapType::accessor& accessor) -> void {
+                this->size.fetch_sub(entry_charge(accessor->second));
+                release_entry(accessor->second);
+                this->map.erase(accessor);
+            }
+
             MapType map;
 
             uint64_t capacity;
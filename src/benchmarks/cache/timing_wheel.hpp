@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <algorithm>
+
+namespace CacheBenchmark {
+    // Hierarchical timing wheel with 1 tick granularity (the benchmark uses milliseconds).
+    // Level 0 has 256 slots of 1 tick, every next level has 64 slots, each covering a whole rotation of the level below.
+    // Any thread can schedule, but only a single thread may advance the wheel.
+    class TimingWheel {
+        public:
+            TimingWheel(uint64_t now) : current(now) {
+            }
+
+            auto schedule(uint64_t key, uint64_t deadline) -> void {
+                this->insert({ key, deadline }, this->current.load(std::memory_order_acquire));
+            }
+
+            // Expires everything up to (and including) now, calls expire(key) for every due key.
+            // Keys may be reported more than once or after they were already renewed, expire has to re-check them.
+            template<typename F>
+            auto advance(uint64_t now, F&& expire) -> uint64_t {
+                uint64_t num_expired = 0;
+                auto tick = this->current.load(std::memory_order_relaxed);
+
+                while (tick < now) {
+                    tick++;
+
+                    // Cascade upper levels down once the level below completed a rotation,
+                    // highest level first so the cascaded items land in slots that weren't drained yet
+                    uint32_t top_level = 0;
+                    while (top_level + 1 < NUM_LEVELS && (tick & ((uint64_t(1) << level_shift(top_level + 1)) - 1)) == 0) {
+                        top_level++;
+                    }
+
+                    for (auto level = top_level; level > 0; level--) {
+                        this->drain(level, (tick >> level_shift(level)) & (UPPER_SLOTS - 1), tick, expire, num_expired);
+                    }
+
+                    this->drain(0, tick & (LOWER_SLOTS - 1), tick, expire, num_expired);
+                    this->current.store(tick, std::memory_order_release);
+                }
+
+                return num_expired;
+            }
+
+        private:
+            struct Item {
+                uint64_t key;
+                uint64_t deadline;
+            };
+
+            struct Slot {
+                std::mutex mtx;
+                std::vector<Item> items;
+            };
+
+            static constexpr uint32_t NUM_LEVELS = 4;
+            static constexpr uint64_t LOWER_BITS = 8;
+            static constexpr uint64_t UPPER_BITS = 6;
+            static constexpr uint64_t LOWER_SLOTS = uint64_t(1) << LOWER_BITS;
+            static constexpr uint64_t UPPER_SLOTS = uint64_t(1) << UPPER_BITS;
+
+            static constexpr auto level_shift(uint32_t level) -> uint64_t {
+                return level == 0 ? 0 : LOWER_BITS + (level - 1) * UPPER_BITS;
+            }
+
+            auto insert(const Item& item, uint64_t now) -> void {
+                // Already due items go into the next slot, a concurrent advance might still
+                // skip it, in which case it gets expired one rotation late
+                auto deadline = std::max(item.deadline, now + 1);
+                auto delta = deadline - now;
+
+                uint32_t level = 0;
+                while (level + 1 < NUM_LEVELS && delta >= (uint64_t(1) << level_shift(level + 1))) {
+                    level++;
+                }
+
+                // Deadlines beyond the last level get clamped, they are rescheduled once drained
+                auto max_delta = uint64_t(1) << (level_shift(NUM_LEVELS - 1) + UPPER_BITS);
+                if (delta >= max_delta) {
+                    deadline = now + max_delta - 1;
+                }
+
+                // An item due in the period starting right after now belongs to the slot a concurrent advance may just
+                // have cascaded, it would wait a whole rotation of the level. The level below still covers it.
+                while (level > 0 && (deadline >> level_shift(level)) == ((now + 1) >> level_shift(level))) {
+                    level--;
+                }
+
+                auto mask = (level == 0) ? (LOWER_SLOTS - 1) : (UPPER_SLOTS - 1);
+                auto& slot = this->levels[level][(deadline >> level_shift(level)) & mask];
+
+                std::lock_guard<std::mutex> lock(slot.mtx);
+                slot.items.push_back(item);
+            }
+
+            template<typename F>
+            auto drain(uint32_t level, uint64_t index, uint64_t tick, F& expire, uint64_t& num_expired) -> void {
+                std::vector<Item> items;
+
+                {
+                    auto& slot = this->levels[level][index];
+                    std::lock_guard<std::mutex> lock(slot.mtx);
+                    items.swap(slot.items);
+                }
+
+                for (auto& item : items) {
+                    if (item.deadline <= tick) {
+                        if (expire(item.key)) {
+                            num_expired++;
+                        }
+                    } else {
+                        // Not due yet, cascade it closer to it's deadline
+                        this->insert(item, tick);
+                    }
+                }
+            }
+
+            std::array<std::array<Slot, LOWER_SLOTS>, NUM_LEVELS> levels{};
+            std::atomic<uint64_t> current;
+    };
+}
@@ -0,0 +1,281 @@
+#pragma once
+#include <string>
+#include <random>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/barrier.hpp"
+#include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+
+namespace ChurnBenchmark {
+    struct BenchmarkOptions {
+        uint64_t seed;
+        uint64_t num_live;              // Entries in the map at any time, split over the threads
+        uint64_t duration_ms;           // Length of the churn phase of a run
+        uint64_t window_ms;             // Throughput and latencies are reported per window
+    };
+
+    // Keys are never 0 and values never 0 or 1, Junction reserves them
+    inline auto value_of(uint64_t key) -> uint64_t {
+        return key * 2 + 2;
+    }
+
+    // Keys which are never inserted, looked up to measure how long a miss has to search
+    constexpr uint64_t ABSENT_KEY_BIT = 1ull << 62;
+
+    struct Window {
+        uint64_t num_steps = 0;
+        uint64_t hit_ns = 0;
+        uint64_t miss_ns = 0;
+    };
+
+    struct ThreadStats {
+        std::vector<Window> windows;
+
+        uint64_t num_steps = 0;
+        uint64_t num_failed = 0;        // Erases of live keys or lookups of absent keys that went wrong
+        uint64_t num_present = 0;       // Live keys found after the run
+    };
+
+    // Every step erases the thread's oldest key and inserts a fresh one, then looks up a live and an absent key.
+    // The keys of thread t are t + 1, t + 1 + n, t + 1 + 2n, ... in insertion order, so no key is ever reused.
+    template<typename T>
+    inline auto benchmark_worker(SpinBarrier& barrier, T& map, const BenchmarkOptions& options, uint64_t seed, uint32_t thread, uint32_t num_threads, PhaseTimes& load_times, PhaseTimes& churn_times, PerfTotals& perf, ThreadStats& stats) -> void {
+        uint64_t num_live = options.num_live / num_threads + (thread < options.num_live % num_threads ? 1 : 0);
+        std::vector<uint64_t> live(num_live);
+        std::mt19937_64 rng(seed);
+        uint64_t next = 0;
+
+        auto fresh_key = [&]() {
+            return (next++) * num_threads + thread + 1;
+        };
+
+        // Load phase, fills the live set
+        barrier.arrive_and_wait();
+        load_times.begin(thread);
+
+        for (uint64_t i = 0; i < num_live; i++) {
+            live[i] = fresh_key();
+            map.insert(live[i], value_of(live[i]));
+            load_times.set_progress(thread, i + 1);
+        }
+
+        load_times.end(thread);
+
+        // Churn phase, runs for the given duration
+        PerfCounters counters;
+        auto duration_ns = options.duration_ms * 1000000;
+        auto window_ns = options.window_ms * 1000000;
+        uint64_t oldest = 0;
+
+        stats.windows.resize((duration_ns + window_ns - 1) / window_ns);
+
+        barrier.arrive_and_wait();
+        churn_times.begin(thread);
+        counters.start();
+
+        auto phase_start = barrier.get_release_timepoint();
+
+        while (num_live > 0) {
+            auto key = fresh_key();
+            stats.num_failed += map.erase(live[oldest]) ? 0 : 1;
+            map.insert(key, value_of(key));
+            live[oldest] = key;
+            oldest = (oldest + 1 == num_live) ? 0 : oldest + 1;
+
+            uint64_t value = 0;
+            auto hit_key = live[rng() % num_live];
+            auto absent_key = ABSENT_KEY_BIT | (rng() >> 2);
+
+            auto start = get_timepoint();
+            auto hit = map.read(hit_key, value) && value == value_of(hit_key);
+            auto middle = get_timepoint();
+            auto miss = !map.read(absent_key, value);
+            auto end = get_timepoint();
+
+            stats.num_failed += (hit ? 0 : 1) + (miss ? 0 : 1);
+            stats.num_steps++;
+            churn_times.set_progress(thread, stats.num_steps);
+
+            auto elapsed = get_duration(phase_start, end);
+            if (elapsed >= duration_ns) {
+                break;
+            }
+
+            auto& window = stats.windows[elapsed / window_ns];
+            window.num_steps++;
+            window.hit_ns += get_duration(start, middle);
+            window.miss_ns += get_duration(middle, end);
+        }
+
+        counters.stop();
+        churn_times.end(thread);
+        perf.add(counters.read(), stats.num_steps);
+
+        for (auto key : live) {
+            uint64_t value = 0;
+            stats.num_present += (map.read(key, value) && value == value_of(key)) ? 1 : 0;
+        }
+    }
+
+    // Ratio of the last window to the first, 0 when there's nothing to compare
+    inline auto drift_of(const std::vector<uint64_t>& values) -> double {
+        if (values.size() < 2 || values.front() == 0) {
+            return 0.0;
+        }
+
+        return static_cast<double>(values.back()) / values.front();
+    }
+
+    template<typename T>
+    inline auto benchmark_impl(const BenchmarkOptions& options, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
+        T map;
+        RunResult result{};
+
+        SpinBarrier barrier(num_threads + 1);
+        PerfTotals perf;
+        PhaseTimes load_times(num_threads);
+        PhaseTimes churn_times(num_threads);
+        std::vector<ThreadStats> stats(num_threads);
+
+        TaskGroup workers;
+        for (uint32_t i = 0; i < num_threads; i++) {
+            workers.run(
+                i,
+                &benchmark_worker<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(options),
+                options.seed + i,
+                i,
+                num_threads,
+                std::ref(load_times),
+                std::ref(churn_times),
+                std::ref(perf),
+                std::ref(stats[i])
+            );
+        }
+
+        Timer load;
+        barrier.arrive_and_wait();
+        load.start_at(barrier.get_release_timepoint());
+
+        Timer t;
+        barrier.arrive_and_wait();
+        load.end_at(barrier.get_release_timepoint());
+        t.start_at(barrier.get_release_timepoint());
+
+        // The main thread only wakes up once per window, to read the RSS
+        auto duration_ns = options.duration_ms * 1000000;
+        auto window_ns = options.window_ms * 1000000;
+        std::vector<uint64_t> rss;
+
+        for (uint64_t window_end = window_ns; window_end <= duration_ns; window_end += window_ns) {
+            auto elapsed = get_duration(t.get_start(), get_timepoint());
+            if (elapsed < window_end) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(window_end - elapsed));
+            }
+
+            rss.push_back(get_rss());
+        }
+
+        workers.wait();
+        t.end();
+
+        load_times.report(result, "load", load);
+        churn_times.report(result, "churn", t);
+
+        // Per window throughput (steps/s) and average lookup latencies
+        TimeSeries throughput{ "churn", static_cast<uint32_t>(options.window_ms), "ops/s" };
+        TimeSeries hit_latency{ "churn_hit_latency", static_cast<uint32_t>(options.window_ms), "ns" };
+        TimeSeries miss_latency{ "churn_miss_latency", static_cast<uint32_t>(options.window_ms), "ns" };
+        TimeSeries rss_series{ "churn_rss", static_cast<uint32_t>(options.window_ms), "bytes" };
+
+        for (uint64_t i = 0; i * window_ns < duration_ns; i++) {
+            Window total;
+            for (auto& thread_stats : stats) {
+                total.num_steps += thread_stats.windows[i].num_steps;
+                total.hit_ns += thread_stats.windows[i].hit_ns;
+                total.miss_ns += thread_stats.windows[i].miss_ns;
+            }
+
+            auto end = std::min((i + 1) * window_ns, duration_ns);
+            auto length = end - i * window_ns;
+
+            throughput.time_ns.push_back(end);
+            throughput.values.push_back(static_cast<uint64_t>(total.num_steps * 1e9 / length));
+            hit_latency.time_ns.push_back(end);
+            hit_latency.values.push_back(total.num_steps > 0 ? total.hit_ns / total.num_steps : 0);
+            miss_latency.time_ns.push_back(end);
+            miss_latency.values.push_back(total.num_steps > 0 ? total.miss_ns / total.num_steps : 0);
+        }
+
+        for (uint64_t i = 0; i < rss.size(); i++) {
+            rss_series.time_ns.push_back((i + 1) * window_ns);
+            rss_series.values.push_back(rss[i]);
+        }
+
+        uint64_t num_steps = 0, num_failed = 0, num_present = 0;
+        for (auto& thread_stats : stats) {
+            num_steps += thread_stats.num_steps;
+            num_failed += thread_stats.num_failed;
+            num_present += thread_stats.num_present;
+        }
+
+        result.value = num_steps;
+        result.hash = num_present;          // Has to be the whole live set
+
+        result.metrics["ops_per_sec"] = t.get_duration() > 0 ? num_steps * 1e9 / t.get_duration() : 0.0;
+        result.metrics["num_failed"] = num_failed;
+        result.metrics["throughput_drift"] = drift_of(throughput.values);
+        result.metrics["hit_latency_drift"] = drift_of(hit_latency.values);
+        result.metrics["miss_latency_drift"] = drift_of(miss_latency.values);
+        result.metrics["rss_growth_bytes"] = rss.size() > 1 ? static_cast<double>(rss.back()) - static_cast<double>(rss.front()) : 0.0;
+
+        std::cout << "Churn: " << static_cast<uint64_t>(result.metrics["ops_per_sec"]) << " steps/s, throughput x" << result.metrics["throughput_drift"]
+            << ", miss latency x" << result.metrics["miss_latency_drift"] << " (first to last window)" << std::endl;
+
+        result.timeseries.push_back(std::move(throughput));
+        result.timeseries.push_back(std::move(hit_latency));
+        result.timeseries.push_back(std::move(miss_latency));
+        result.timeseries.push_back(std::move(rss_series));
+
+        // An operation is a whole step, erase + insert + 2 lookups
+        perf.report(result);
+
+        memory.finish();
+        report_memory(result, memory, options.num_live);
+
+        introspect_map(map, result);
+
+        return result;
+    }
+
+    template<typename T>
+    inline auto run_benchmark(const std::string& impl, const BenchmarkOptions& options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
+        BenchmarkResult result{};
+
+        result.impl = impl;
+        result.value_unit = "";
+        result.num_threads = num_threads;
+
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(options, num_threads);
+        });
+
+        return result;
+    }
+}
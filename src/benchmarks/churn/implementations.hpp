@@ -0,0 +1,55 @@
+#pragma once
+#include "libcuckoo.hpp"
+#include "stdmap.hpp"
+#include "tbbmap.hpp"
+#include "junction.hpp"
+#include "../registry.hpp"
+
+namespace ChurnBenchmark {
+    // Implementations selectable with --implementation, in the order "all" runs them.
+    // tbb::concurrent_unordered_map can't erase concurrently and isn't part of this benchmark.
+    struct CuckooImpl {
+        using Map = CuckooMap;
+        static constexpr const char* name = "libcuckoo";
+        static constexpr const char* description = "libcuckoo";
+    };
+
+    struct TBBHashImpl {
+        using Map = TBBHashMap;
+        static constexpr const char* name = "tbb-hash";
+        static constexpr const char* description = "TBB concurrent_hash_map";
+    };
+
+    struct STDBlockingImpl {
+        using Map = STDMap;
+        static constexpr const char* name = "std-blocking";
+        static constexpr const char* description = "Blocking STD";
+    };
+
+    struct JunctionGrampaImpl {
+        using Map = JunctionMapGrampa;
+        static constexpr const char* name = "junction-grampa";
+        static constexpr const char* description = "Junction ConcurrentMap_Grampa";
+    };
+
+    struct JunctionLeapfrogImpl {
+        using Map = JunctionMapLeapfrog;
+        static constexpr const char* name = "junction-leapfrog";
+        static constexpr const char* description = "Junction ConcurrentMap_Leapfrog";
+    };
+
+    struct JunctionLinearImpl {
+        using Map = JunctionMapLinear;
+        static constexpr const char* name = "junction-linear";
+        static constexpr const char* description = "Junction ConcurrentMap_Linear";
+    };
+
+    using Implementations = Registry<
+        CuckooImpl,
+        TBBHashImpl,
+        STDBlockingImpl,
+        JunctionGrampaImpl,
+        JunctionLeapfrogImpl,
+        JunctionLinearImpl
+    >;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "churn.hpp"
+#include <junction/ConcurrentMap_Grampa.h>
+#include <junction/ConcurrentMap_Leapfrog.h>
+#include <junction/ConcurrentMap_Linear.h>
+
+namespace ChurnBenchmark {
+    // Erased keys stay in their cells (with a null value) until the table is migrated,
+    // churning through fresh keys fills the table with them
+    template<typename MapType>
+    class JunctionMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.assign(key, value);
+            }
+
+            auto erase(uint64_t key) -> bool {
+                return this->map.erase(key) != 0;
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                value = this->map.get(key);
+                return value != 0;
+            }
+
+            // Junction doesn't expose its cells
+            auto introspect(MapStats&) -> void {
+            }
+
+        private:
+            MapType map;
+    };
+
+    using JunctionMapGrampa = JunctionMap<junction::ConcurrentMap_Grampa<uint64_t, uint64_t>>;
+    using JunctionMapLeapfrog = JunctionMap<junction::ConcurrentMap_Leapfrog<uint64_t, uint64_t>>;
+    using JunctionMapLinear = JunctionMap<junction::ConcurrentMap_Linear<uint64_t, uint64_t>>;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "churn.hpp"
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace ChurnBenchmark {
+    class CuckooMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.insert(key, value);
+            }
+
+            auto erase(uint64_t key) -> bool {
+                return this->map.erase(key);
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                return this->map.find(key, value);
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            libcuckoo::cuckoohash_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, uint64_t>> map;
+    };
+}
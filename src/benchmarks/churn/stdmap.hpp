@@ -0,0 +1,39 @@
+#pragma once
+#include "churn.hpp"
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace ChurnBenchmark {
+    class STDMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                std::unique_lock lock(this->mtx);
+                this->map.insert({key, value});
+            }
+
+            auto erase(uint64_t key) -> bool {
+                std::unique_lock lock(this->mtx);
+                return this->map.erase(key) > 0;
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                std::shared_lock lock(this->mtx);
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                value = result->second;
+                return true;
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, uint64_t>> map;
+            std::shared_mutex mtx;
+    };
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "churn.hpp"
+#include <tbb/concurrent_hash_map.h>
+
+namespace ChurnBenchmark {
+    class TBBHashMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.insert({key, value});
+            }
+
+            auto erase(uint64_t key) -> bool {
+                return this->map.erase(key);
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                MapType::const_accessor accessor;
+                if (!this->map.find(accessor, key)) {
+                    return false;
+                }
+
+                value = accessor->second;
+                return true;
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            using MapType = tbb::concurrent_hash_map<uint64_t, uint64_t, tbb::tbb_hash_compare<uint64_t>, MapAllocator<uint64_t, uint64_t>>;
+            MapType map;
+    };
+}
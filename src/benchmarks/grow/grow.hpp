@@ -0,0 +1,342 @@
+#pragma once
+#include <string>
+#include <random>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/barrier.hpp"
+#include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
+#include "../../utils/latency_histogram.hpp"
+
+namespace GrowBenchmark {
+    struct BenchmarkOptions {
+        uint64_t seed;
+        uint64_t num_entries;           // Inserted per run into an empty map, split over the inserting threads
+        uint32_t num_readers;           // Threads reading already inserted keys while the map grows
+        uint64_t stall_ns;              // Operations taking at least this long count as stalls
+    };
+
+    // Keys are never 0, Junction reserves it. Inserter i owns the keys i + 1, i + 1 + n, i + 1 + 2n, ...
+    inline auto key_of(uint64_t index) -> uint64_t {
+        return index + 1;
+    }
+
+    inline auto value_of(uint64_t key) -> uint64_t {
+        return key * 2 + 2;
+    }
+
+    // An operation which saw the map's capacity change while it ran, i.e. overlapped a resize or migration
+    struct ResizeObservation {
+        uint64_t capacity;              // Capacity after the operation
+        uint64_t start_ns;              // Start of the operation, relative to the phase start
+        uint64_t latency_ns;
+        bool reader;
+    };
+
+    struct ThreadStats {
+        LatencyHistogram latencies;
+        std::vector<ResizeObservation> resizes;
+
+        uint64_t num_operations = 0;
+        uint64_t num_hits = 0;
+        uint64_t num_stalls = 0;
+        uint64_t stall_ns = 0;
+    };
+
+    // Shared by inserters and readers of a run
+    struct GrowState {
+        std::atomic<uint32_t> inserting;
+        std::atomic<bool> done = false;
+    };
+
+    // Times a single operation, checking the capacity right before and after it
+    template<typename T, typename F>
+    inline auto timed(T& map, const BenchmarkOptions& options, uint64_t phase_start, ThreadStats& stats, bool reader, F&& operation) -> void {
+        auto capacity = map.get_capacity();
+        auto start = get_timepoint();
+        operation();
+        auto end = get_timepoint();
+        auto new_capacity = map.get_capacity();
+
+        auto latency = get_duration(start, end);
+        stats.latencies.record(latency);
+        stats.num_operations++;
+
+        if (latency >= options.stall_ns) {
+            stats.num_stalls++;
+            stats.stall_ns += latency;
+        }
+
+        if (new_capacity != capacity) {
+            stats.resizes.push_back(ResizeObservation{ new_capacity, get_duration(phase_start, start), latency, reader });
+        }
+    }
+
+    template<typename T>
+    inline auto insert_worker(SpinBarrier& barrier, T& map, const BenchmarkOptions& options, GrowState& state, uint32_t thread, uint32_t num_threads, PhaseTimes& times, PerfTotals& perf, ThreadStats& stats) -> void {
+        PerfCounters counters;
+        uint64_t num_inserts = options.num_entries / num_threads + (thread < options.num_entries % num_threads ? 1 : 0);
+
+        barrier.arrive_and_wait();
+        times.begin(thread);
+        counters.start();
+
+        auto phase_start = barrier.get_release_timepoint();
+
+        for (uint64_t i = 0; i < num_inserts; i++) {
+            auto key = key_of(i * num_threads + thread);
+
+            timed(map, options, phase_start, stats, false, [&]() {
+                map.insert(key, value_of(key));
+            });
+
+            times.set_progress(thread, i + 1);
+        }
+
+        counters.stop();
+        times.end(thread);
+        perf.add(counters.read(), num_inserts);
+
+        if (state.inserting.fetch_sub(1) == 1) {
+            state.done.store(true, std::memory_order_release);
+        }
+    }
+
+    // Reads keys every inserter already inserted (hits), until the last inserter is done
+    template<typename T>
+    inline auto read_worker(SpinBarrier& barrier, T& map, const BenchmarkOptions& options, GrowState& state, const PhaseTimes& times, uint64_t seed, uint32_t num_inserters, ThreadStats& stats) -> void {
+        std::mt19937_64 rng(seed);
+        uint64_t num_present = 0;
+
+        barrier.arrive_and_wait();
+
+        auto phase_start = barrier.get_release_timepoint();
+
+        while (!state.done.load(std::memory_order_acquire)) {
+            // Refreshed now and then, every inserter finished the first num_present / num_inserters of its keys
+            if ((stats.num_operations & 1023) == 0) {
+                uint64_t min_progress = UINT64_MAX;
+                for (uint32_t i = 0; i < num_inserters; i++) {
+                    min_progress = std::min(min_progress, times.get_progress(i));
+                }
+
+                num_present = min_progress * num_inserters;
+            }
+
+            auto key = key_of(num_present > 0 ? rng() % num_present : 0);
+            uint64_t value = 0;
+            bool found = false;
+
+            timed(map, options, phase_start, stats, true, [&]() {
+                found = map.read(key, value);
+            });
+
+            stats.num_hits += (found && value == value_of(key)) ? 1 : 0;
+        }
+    }
+
+    // Observations merged by the capacity they saw, one event per resize / migration
+    struct ResizeEvent {
+        uint64_t capacity;
+        uint64_t start_ns;
+        uint64_t insert_latency_ns = 0;     // Longest insert overlapping the resize
+        uint64_t read_latency_ns = 0;       // Longest read overlapping it
+        uint64_t num_reads = 0;
+    };
+
+    inline auto merge_resizes(const std::vector<ThreadStats>& stats) -> std::vector<ResizeEvent> {
+        std::vector<ResizeObservation> observations;
+        for (auto& thread_stats : stats) {
+            observations.insert(observations.end(), thread_stats.resizes.begin(), thread_stats.resizes.end());
+        }
+
+        std::sort(observations.begin(), observations.end(), [](auto& a, auto& b) {
+            return a.capacity < b.capacity || (a.capacity == b.capacity && a.start_ns < b.start_ns);
+        });
+
+        std::vector<ResizeEvent> events;
+        for (auto& observation : observations) {
+            if (events.empty() || events.back().capacity != observation.capacity) {
+                events.push_back(ResizeEvent{ observation.capacity, observation.start_ns });
+            }
+
+            auto& event = events.back();
+            if (observation.reader) {
+                event.read_latency_ns = std::max(event.read_latency_ns, observation.latency_ns);
+                event.num_reads++;
+            } else {
+                event.insert_latency_ns = std::max(event.insert_latency_ns, observation.latency_ns);
+            }
+        }
+
+        std::sort(events.begin(), events.end(), [](auto& a, auto& b) { return a.start_ns < b.start_ns; });
+        return events;
+    }
+
+    template<typename T>
+    inline auto benchmark_impl(const BenchmarkOptions& options, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
+        T map;
+        RunResult result{};
+
+        SpinBarrier barrier(num_threads + options.num_readers + 1);
+        GrowState state{ { num_threads } };
+        PerfTotals perf;
+        PhaseTimes times(num_threads);
+        std::vector<ThreadStats> stats(num_threads + options.num_readers);
+
+        // Readers get the slots after the inserters
+        TaskGroup readers;
+        for (uint32_t i = 0; i < options.num_readers; i++) {
+            readers.run(
+                num_threads + i,
+                &read_worker<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(options),
+                std::ref(state),
+                std::cref(times),
+                options.seed + num_threads + i,
+                num_threads,
+                std::ref(stats[num_threads + i])
+            );
+        }
+
+        TaskGroup inserters;
+        for (uint32_t i = 0; i < num_threads; i++) {
+            inserters.run(
+                i,
+                &insert_worker<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(options),
+                std::ref(state),
+                i,
+                num_threads,
+                std::ref(times),
+                std::ref(perf),
+                std::ref(stats[i])
+            );
+        }
+
+        Timer t;
+        barrier.arrive_and_wait();
+        t.start_at(barrier.get_release_timepoint());
+
+        ThroughputSampler sampler(times);
+        sampler.start(t.get_start());
+
+        inserters.wait();
+        t.end();
+        sampler.stop();
+        readers.wait();
+
+        result.value = t.get_duration();
+
+        // Every key has to be there, with the right value
+        uint64_t num_found = 0;
+        for (uint64_t i = 0; i < options.num_entries; i++) {
+            uint64_t value = 0;
+            num_found += (map.read(key_of(i), value) && value == value_of(key_of(i))) ? 1 : 0;
+        }
+
+        result.hash = num_found;
+
+        times.report(result, "grow", t);
+        sampler.report(result, "grow");
+        perf.report(result);
+
+        LatencyHistogram insert_latencies;
+        LatencyHistogram read_latencies;
+        uint64_t insert_stalls = 0, read_stalls = 0, read_stall_ns = 0, num_hits = 0;
+
+        for (uint32_t i = 0; i < stats.size(); i++) {
+            if (i < num_threads) {
+                insert_latencies.merge(stats[i].latencies);
+                insert_stalls += stats[i].num_stalls;
+            } else {
+                read_latencies.merge(stats[i].latencies);
+                read_stalls += stats[i].num_stalls;
+                read_stall_ns += stats[i].stall_ns;
+                num_hits += stats[i].num_hits;
+            }
+        }
+
+        insert_latencies.report(result, "insert");
+        result.metrics["insert_stalls"] = insert_stalls;
+        result.metrics["ops_per_sec"] = result.value > 0 ? options.num_entries * 1e9 / result.value : 0.0;
+
+        if (options.num_readers > 0) {
+            read_latencies.report(result, "read");
+            result.metrics["read_stalls"] = read_stalls;
+            result.metrics["read_stall_ns"] = read_stall_ns;
+            result.metrics["num_reads"] = read_latencies.get_count();
+            result.metrics["num_read_hits"] = num_hits;
+            result.metrics["reads_per_sec"] = result.value > 0 ? read_latencies.get_count() * 1e9 / result.value : 0.0;
+        }
+
+        // Resizes, only for maps exposing their capacity
+        auto events = merge_resizes(stats);
+        uint64_t max_resize_ns = 0, total_resize_ns = 0, resize_reads = 0, max_resize_read_ns = 0;
+
+        for (uint32_t i = 0; i < events.size(); i++) {
+            auto& event = events[i];
+            auto prefix = "resize_" + std::to_string(i);
+
+            result.metrics[prefix + "_at_ns"] = event.start_ns;
+            result.metrics[prefix + "_capacity"] = event.capacity;
+            result.metrics[prefix + "_latency_ns"] = event.insert_latency_ns;
+
+            max_resize_ns = std::max(max_resize_ns, event.insert_latency_ns);
+            total_resize_ns += event.insert_latency_ns;
+            resize_reads += event.num_reads;
+            max_resize_read_ns = std::max(max_resize_read_ns, event.read_latency_ns);
+        }
+
+        result.metrics["final_capacity"] = map.get_capacity();
+        result.metrics["num_resizes"] = events.size();
+        result.metrics["resize_latency_max_ns"] = max_resize_ns;
+        result.metrics["resize_latency_avg_ns"] = events.empty() ? 0.0 : static_cast<double>(total_resize_ns) / events.size();
+        result.metrics["resize_read_stalls"] = resize_reads;
+        result.metrics["resize_read_stall_max_ns"] = max_resize_read_ns;
+
+        std::cout << "Grow: " << events.size() << " resizes (max " << max_resize_ns / 1000 << "us), insert p99 " << insert_latencies.quantile(0.99) << "ns max " << insert_latencies.get_max() / 1000 << "us";
+        if (options.num_readers > 0) {
+            std::cout << ", read p99 " << read_latencies.quantile(0.99) << "ns max " << read_latencies.get_max() / 1000 << "us, " << resize_reads << " reads during resizes";
+        }
+        std::cout << std::endl;
+
+        memory.finish();
+        report_memory(result, memory, options.num_entries);
+
+        introspect_map(map, result);
+
+        return result;
+    }
+
+    template<typename T>
+    inline auto run_benchmark(const std::string& impl, const BenchmarkOptions& options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
+        BenchmarkResult result{};
+
+        result.impl = impl;
+        result.value_unit = "ns";
+        result.num_threads = num_threads;
+
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(options, num_threads);
+        });
+
+        return result;
+    }
+}
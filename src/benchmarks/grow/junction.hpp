@@ -0,0 +1,35 @@
+#pragma once
+#include "grow.hpp"
+#include <junction/ConcurrentMap_Grampa.h>
+#include <junction/ConcurrentMap_Leapfrog.h>
+
+namespace GrowBenchmark {
+    // Junction migrates to a new table in the background of the accessing threads, without exposing its size.
+    // Migrations only show up as insert and read stalls.
+    template<typename MapType>
+    class JunctionMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.assign(key, value);
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                value = this->map.get(key);
+                return value != 0;
+            }
+
+            auto get_capacity() const -> uint64_t {
+                return 0;
+            }
+
+            // Junction doesn't expose its cells
+            auto introspect(MapStats&) -> void {
+            }
+
+        private:
+            MapType map;
+    };
+
+    using JunctionMapGrampa = JunctionMap<junction::ConcurrentMap_Grampa<uint64_t, uint64_t>>;
+    using JunctionMapLeapfrog = JunctionMap<junction::ConcurrentMap_Leapfrog<uint64_t, uint64_t>>;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "grow.hpp"
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace GrowBenchmark {
+    class CuckooMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.insert(key, value);
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                return this->map.find(key, value);
+            }
+
+            // A cuckoo resize rehashes the whole table while holding every lock
+            auto get_capacity() const -> uint64_t {
+                return this->map.bucket_count() * this->map.slot_per_bucket();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            libcuckoo::cuckoohash_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, uint64_t>> map;
+    };
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "grow.hpp"
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace GrowBenchmark {
+    // Rehashes inside the inserting thread, under the exclusive lock
+    class STDMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                std::unique_lock lock(this->mtx);
+                this->map.insert({key, value});
+                this->capacity.store(this->map.bucket_count(), std::memory_order_relaxed);
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                std::shared_lock lock(this->mtx);
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                value = result->second;
+                return true;
+            }
+
+            // Kept outside of the lock, so checking it doesn't queue behind a rehash
+            auto get_capacity() const -> uint64_t {
+                return this->capacity.load(std::memory_order_relaxed);
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            std::unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, uint64_t>> map;
+            std::shared_mutex mtx;
+            std::atomic<uint64_t> capacity = 0;
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "grow.hpp"
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_unordered_map.h>
+
+namespace GrowBenchmark {
+    // Grows by adding bucket segments, old buckets are split lazily by the accesses finding them
+    class TBBHashMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.insert({key, value});
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                MapType::const_accessor accessor;
+                if (!this->map.find(accessor, key)) {
+                    return false;
+                }
+
+                value = accessor->second;
+                return true;
+            }
+
+            auto get_capacity() const -> uint64_t {
+                return this->map.bucket_count();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            using MapType = tbb::concurrent_hash_map<uint64_t, uint64_t, tbb::tbb_hash_compare<uint64_t>, MapAllocator<uint64_t, uint64_t>>;
+            MapType map;
+    };
+
+    // Split-ordered list, doubling the bucket count only initializes new buckets when they're first used
+    class TBBUnorderedMap {
+        public:
+            auto insert(uint64_t key, uint64_t value) -> void {
+                this->map.insert({key, value});
+            }
+
+            auto read(uint64_t key, uint64_t& value) -> bool {
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                value = result->second;
+                return true;
+            }
+
+            // Only reads the bucket count, safe alongside concurrent inserts
+            auto get_capacity() const -> uint64_t {
+                return this->map.unsafe_bucket_count();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            tbb::concurrent_unordered_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, MapAllocator<uint64_t, uint64_t>> map;
+    };
+}
@@ -6,9 +6,17 @@
 #include <functional>
 #include <tuple>
 #include <fstream>
-#include "../../utils/semaphore.hpp"
+#include "../../utils/barrier.hpp"
 #include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
+#include "../../utils/map_introspection.hpp"
 #include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
 
 namespace HashJoinBenchmark {
     using DatasetAValue = std::tuple<uint32_t, std::string>;
@@ -67,13 +75,22 @@ namespace HashJoinBenchmark {
     }
 
     template<typename T>
-    inline auto benchmark_build_part(Semaphore& sem, const DatasetA& dataset_a, T& map, uint32_t start, uint32_t end) -> void {
-        sem.wait();
+    inline auto benchmark_build_part(SpinBarrier& barrier, const DatasetA& dataset_a, T& map, uint32_t start, uint32_t end, PerfTotals& perf, PhaseTimes& times, uint32_t thread) -> void {
+        PerfCounters counters;
+        barrier.arrive_and_wait();
+        times.begin(thread);
+        counters.start();
 
         for (auto i = start; i < end; i++) {
             auto& item = dataset_a[i];
+            times.set_progress(thread, i - start);
             map.insert(std::get<0>(item), item);
         }
+
+        counters.stop();
+        times.end(thread);
+        times.set_progress(thread, end - start);
+        perf.add(counters.read(), end - start);
     }
 
     template <typename T>
@@ -94,12 +111,16 @@ namespace HashJoinBenchmark {
     }
 
     template<typename T>
-    inline auto benchmark_probe_part(Semaphore& sem, const DatasetB& dataset_b, T& map, uint32_t start, uint32_t end, std::shared_ptr<uint64_t> hash_ptr) -> void {        
+    inline auto benchmark_probe_part(SpinBarrier& barrier, const DatasetB& dataset_b, T& map, uint32_t start, uint32_t end, std::shared_ptr<uint64_t> hash_ptr, PerfTotals& perf, PhaseTimes& times, uint32_t thread) -> void {        
+        PerfCounters counters;
         uint64_t h = 0;
-        sem.wait();
+        barrier.arrive_and_wait();
+        times.begin(thread);
+        counters.start();
 
         for (auto i = start; i < end; i++) {
             auto& item = dataset_b[i];
+            times.set_progress(thread, i - start);
             auto value = map.get(std::get<1>(item));
 
             h = hash_combine(h, hash_result(std::make_tuple(
@@ -111,12 +132,19 @@ namespace HashJoinBenchmark {
             )));
         }
 
+        counters.stop();
+        times.end(thread);
+        times.set_progress(thread, end - start);
+        perf.add(counters.read(), end - start);
+
         *hash_ptr = h;
     }
 
     template<typename T>
     inline auto benchmark_impl(const DatasetA& dataset_a, const DatasetB& dataset_b, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
         T map;
+        PerfTotals perf;
 
         RunResult result{};
 
@@ -124,44 +152,57 @@ namespace HashJoinBenchmark {
         // Build phase
         {
             Timer t;
-            Semaphore sem;
+            SpinBarrier barrier(num_threads + 1);
+            PhaseTimes times(num_threads);
             auto even_split = dataset_a.size() / num_threads;
 
-            std::vector<std::thread> threads;
-            threads.reserve(num_threads);
+            TaskGroup workers;
 
             for (auto i = 0; i < num_threads; i++) {
                 auto start = i * even_split;
                 auto end = (i == num_threads - 1) ? dataset_a.size() : ((i + 1) * even_split);
 
-                threads.emplace_back(
+                workers.run(
+                    i,
                     &benchmark_build_part<T>,
-                    std::ref(sem),
+                    std::ref(barrier),
                     std::cref(dataset_a),
                     std::ref(map),
                     start,
-                    end
+                    end,
+                    std::ref(perf),
+                    std::ref(times),
+                    i
                 );
             }
 
-            t.start();
-            sem.notify_all();
+            barrier.arrive_and_wait();
+            t.start_at(barrier.get_release_timepoint());
 
-            for (auto& th : threads) {
-                th.join();
-            }
+            ThroughputSampler sampler(times);
+            sampler.start(t.get_start());
 
+            workers.wait();
             t.end();
+            sampler.stop();
+
             build_duration = t.get_duration();
+            times.report(result, "build", t);
+            sampler.report(result, "build");
+
+            // Tables replaced while growing, no worker probes them anymore
+            reclaim_map(map);
         }
 
         // Probe phase
         {
             Timer t;
-            Semaphore sem;
+            SpinBarrier barrier(num_threads + 1);
+            PhaseTimes times(num_threads);
 
             auto even_split = dataset_b.size() / num_threads;
-            std::vector<std::tuple<std::thread, std::shared_ptr<uint64_t>>> threads;
+            TaskGroup workers;
+            std::vector<std::shared_ptr<uint64_t>> hashes;
 
             for (auto i = 0; i < num_threads; i++) {
                 auto start = i * even_split;
@@ -169,76 +210,68 @@ namespace HashJoinBenchmark {
 
                 auto hash = std::make_shared<uint64_t>(0);
 
-                threads.push_back(std::make_tuple(
-                    std::thread(
-                        &benchmark_probe_part<T>,
-                        std::ref(sem),
-                        std::cref(dataset_b),
-                        std::ref(map),
-                        start,
-                        end,
-                        hash
-                    ),
-                    hash
-                ));
+                workers.run(
+                    i,
+                    &benchmark_probe_part<T>,
+                    std::ref(barrier),
+                    std::cref(dataset_b),
+                    std::ref(map),
+                    start,
+                    end,
+                    hash,
+                    std::ref(perf),
+                    std::ref(times),
+                    i
+                );
+
+                hashes.push_back(hash);
             }
 
-            t.start();
-            sem.notify_all();
+            barrier.arrive_and_wait();
+            t.start_at(barrier.get_release_timepoint());
+
+            ThroughputSampler sampler(times);
+            sampler.start(t.get_start());
+
+            workers.wait();
+            t.end();
+            sampler.stop();
 
             uint64_t hash = 0;
 
-            for (auto& [t1, h] : threads) {
-                t1.join();
+            for (auto& h : hashes) {
                 hash = hash_combine(hash, *h);
             }
 
-            t.end();
-
             result.hash = hash;
             result.value = t.get_duration() + build_duration;
+            times.report(result, "probe", t);
+            sampler.report(result, "probe");
         }
 
+        // Build and probe counters combined, an operation is a single insert or lookup
+        perf.report(result);
+
+        // Peak is reached while building
+        memory.finish();
+        report_memory(result, memory, dataset_a.size());
+
+        introspect_map(map, result);
+
         return result;
     }
 
     template<typename T>
-    inline auto run_benchmark(const std::string& impl, const DatasetA& dataset_a, const DatasetB& dataset_b, uint32_t num_runs, uint32_t num_threads) -> BenchmarkResult {
+    inline auto run_benchmark(const std::string& impl, const DatasetA& dataset_a, const DatasetB& dataset_b, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
         BenchmarkResult result{};
 
         result.impl = impl;
         result.value_unit = "ns";
-        result.correct = true;
-        result.num_runs = num_runs;
         result.num_threads = num_threads;
 
-        result.total_value = 0;
-        result.min_value = std::numeric_limits<uint64_t>::max();
-        result.max_value = std::numeric_limits<uint64_t>::min();
-
-        result.hash = 0;
-
-        for (uint32_t i = 0; i < num_runs; i++) {
-            std::cout << "Starting iteration " << (i + 1) << "/" << num_runs << std::endl;
-            auto run_result = benchmark_impl<T>(dataset_a, dataset_b, num_threads);
-
-            if (i == 0) {
-                result.hash = run_result.hash;
-            }
-
-            if (run_result.hash != result.hash) {
-                result.correct = false;
-            }
-
-            result.runs.push_back(run_result);          
-            result.total_value += run_result.value;
-
-            result.min_value = std::min(result.min_value, run_result.value);
-            result.max_value = std::max(result.max_value, run_result.value);
-        }
-
-        result.avg_value = result.total_value / result.num_runs;
-        result.mean_value = result.runs[result.num_runs / 2].value;
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(dataset_a, dataset_b, num_threads);
+        });
 
         return result;
     }
@@ -15,7 +15,7 @@ namespace HashJoinBenchmark {
 
                 while (iter.isValid()) {
                     // Delete held value
-                    delete iter.getValue();
+                    heap_delete(iter.getValue());
 
                     // Move to the next element
                     iter.next();
@@ -23,7 +23,7 @@ namespace HashJoinBenchmark {
             }
 
             auto insert(uint32_t key, const DatasetAValue& value) -> void {
-                auto heapValue = new DatasetAValue(value);
+                auto heapValue = heap_new<DatasetAValue>(value);
                 this->map.assign(key, heapValue);
             }
 
@@ -31,6 +31,10 @@ namespace HashJoinBenchmark {
                 return *this->map.get(key);
             }
 
+            // Junction doesn't expose its cells
+            auto introspect(MapStats&) -> void {
+            }
+
         private:
             MapType map;
     };
@@ -13,7 +13,11 @@ namespace HashJoinBenchmark {
                 return this->map.find(key);
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            libcuckoo::cuckoohash_map<uint32_t, DatasetAValue> map;
+            libcuckoo::cuckoohash_map<uint32_t, DatasetAValue, std::hash<uint32_t>, std::equal_to<uint32_t>, MapAllocator<uint32_t, DatasetAValue>> map;
     };
 }
\ No newline at end of file
@@ -15,8 +15,12 @@ namespace HashJoinBenchmark {
                 return this->map.at(key);
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            std::unordered_map<uint32_t, DatasetAValue> map;
+            std::unordered_map<uint32_t, DatasetAValue, std::hash<uint32_t>, std::equal_to<uint32_t>, MapAllocator<uint32_t, DatasetAValue>> map;
             std::mutex mtx;
     };
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "hashjoin.hpp"
+#include "../../utils/swiss_map.hpp"
+
+namespace HashJoinBenchmark {
+    // Rows hold strings, which can't be copied optimistically, so the table holds pointers to them (like Junction).
+    // Unlike Junction the rows are counted, the table is measured by the counting allocator as well.
+    class SwissMap {
+        public:
+            ~SwissMap() {
+                this->map.for_each([](uint32_t, DatasetAValue* value) {
+                    destroy(value);
+                });
+            }
+
+            auto insert(uint32_t key, const DatasetAValue& value) -> void {
+                auto heapValue = new (CountingAllocator<DatasetAValue>{}.allocate(1)) DatasetAValue(value);
+
+                if (!this->map.insert(key, heapValue)) {
+                    destroy(heapValue);
+                }
+            }
+
+            auto get(uint32_t key) -> const DatasetAValue& {
+                DatasetAValue* value = nullptr;
+                this->map.find(key, value);
+                return *value;
+            }
+
+            // Only between phases
+            auto reclaim() -> void {
+                this->map.reclaim();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            static auto destroy(DatasetAValue* value) -> void {
+                value->~DatasetAValue();
+                CountingAllocator<DatasetAValue>{}.deallocate(value, 1);
+            }
+
+            ConcurrentSwissMap<uint32_t, DatasetAValue*> map;
+    };
+}
@@ -19,8 +19,12 @@ namespace HashJoinBenchmark {
                 return value_copy;
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            using MapType = tbb::concurrent_hash_map<uint32_t, DatasetAValue>;
+            using MapType = tbb::concurrent_hash_map<uint32_t, DatasetAValue, tbb::tbb_hash_compare<uint32_t>, MapAllocator<uint32_t, DatasetAValue>>;
             MapType map;
     };
 
@@ -35,7 +39,11 @@ namespace HashJoinBenchmark {
                 return result->second;
             }
 
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            tbb::concurrent_unordered_map<uint32_t, DatasetAValue> map;
+            tbb::concurrent_unordered_map<uint32_t, DatasetAValue, std::hash<uint32_t>, std::equal_to<uint32_t>, MapAllocator<uint32_t, DatasetAValue>> map;
     };
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include "benchmark.hpp"
+#include "../utils/memory.hpp"
+
+// Writes what the run's MemoryProbe measured into its metrics, num_entries is what the map held afterwards
+inline auto report_memory(RunResult& result, const MemoryProbe& probe, uint64_t num_entries) -> void {
+    auto& usage = probe.get_usage();
+
+    // Of the whole process, the datasets included
+    if (HugePages::mode().load() != HugePageMode::Off) {
+        result.metrics["huge_page_bytes"] = usage.huge_pages;
+        std::cout << "Huge pages: " << (usage.huge_pages >> 20) << "MiB in use" << std::endl;
+    }
+
+    if (!usage.measured) {
+        return;
+    }
+
+    auto memory = usage.counted ? usage.allocated : usage.rss;
+    auto memory_peak = usage.counted ? usage.allocated_peak : std::max(usage.rss_peak, usage.rss);
+
+    if (usage.counted) {
+        result.metrics["allocated_bytes"] = usage.allocated;
+        result.metrics["allocated_peak_bytes"] = usage.allocated_peak;
+    }
+
+    result.metrics["rss_delta_bytes"] = usage.rss;
+    if (usage.peak_rss_valid) {
+        result.metrics["rss_peak_delta_bytes"] = usage.rss_peak;
+    }
+
+    // Chunks of the pools / arena, allocated_bytes only counts the bytes the map asked for
+    if (MapHeap::kind().load() != HeapKind::Std) {
+        result.metrics["heap_reserved_bytes"] = usage.reserved;
+    }
+
+    result.metrics["memory_bytes"] = memory;
+    result.metrics["memory_peak_bytes"] = memory_peak;
+    result.metrics["memory_entries"] = num_entries;
+    result.metrics["bytes_per_entry"] = num_entries > 0 ? static_cast<double>(memory) / num_entries : 0.0;
+
+    std::cout << "Map memory: " << (memory / 1024) << "KiB (" << (usage.counted ? "allocated" : "RSS") << ", peak " << (memory_peak / 1024) << "KiB), "
+        << (num_entries > 0 ? memory / num_entries : 0) << " bytes per entry" << std::endl;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include "benchmark.hpp"
+#include "../utils/affinity.hpp"
+#include "../utils/map_heap.hpp"
+
+// Compile time list of a benchmark's map implementations. Each entry is a type with
+// using Map = <map type>; and static constexpr const char* name, description;
+template<typename... Entries>
+struct Registry {
+    static auto names() -> std::vector<std::string> {
+        return { Entries::name... };
+    }
+
+    static auto contains(const std::string& name) -> bool {
+        return ((name == Entries::name) || ...);
+    }
+
+    // Calls run(Entry{}) with the entry registered under name, returns false if there is none
+    template<typename F>
+    static auto visit(const std::string& name, F&& run) -> bool {
+        return ((name == Entries::name ? (run(Entries{}), true) : false) || ...);
+    }
+
+    // Expands "all", exits on unknown names
+    static auto resolve(const std::vector<std::string>& selected) -> std::vector<std::string> {
+        std::vector<std::string> result;
+
+        for (auto& name : selected) {
+            if (name == "all") {
+                for (auto& impl : names()) {
+                    result.push_back(impl);
+                }
+            } else if (contains(name)) {
+                result.push_back(name);
+            } else {
+                std::cerr << "Unknown implementation " << name << std::endl;
+                std::exit(-1);
+            }
+        }
+
+        return result;
+    }
+
+    // Comma separated names, for the help text
+    static auto list() -> std::string {
+        std::string result;
+
+        for (auto& name : names()) {
+            result += name + ", ";
+        }
+
+        return result + "all";
+    }
+};
+
+// Runs every selected implementation with every thread count in a single process, the benchmark
+// specific run(Entry{}, num_threads) is responsible for reusing the already loaded dataset
+template<typename R, typename F>
+inline auto run_matrix(const std::vector<std::string>& impls, const std::vector<uint32_t>& thread_counts, F&& run) -> std::vector<BenchmarkResult> {
+    std::vector<BenchmarkResult> results;
+
+    for (auto& impl : impls) {
+        for (auto num_threads : thread_counts) {
+            R::visit(impl, [&](auto entry) {
+                using Entry = decltype(entry);
+                std::cout << "Benchmarking " << Entry::description << " with " << num_threads << " threads!" << std::endl;
+                results.push_back(run(entry, num_threads));
+                results.back().layout = thread_placement().get_layout(num_threads);
+                results.back().allocator = heap_kind_name(MapHeap::kind().load());
+                results.back().hugepages = huge_page_mode_name(HugePages::mode().load());
+            });
+        }
+    }
+
+    return results;
+}
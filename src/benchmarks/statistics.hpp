@@ -0,0 +1,174 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include "benchmark.hpp"
+#include "../utils/map_heap.hpp"
+
+// How many times a benchmark is run, shared by all benchmarks
+struct RunSettings {
+    uint32_t num_runs = 10;         // Exact number of runs, or the minimum with a target CI
+    uint32_t num_warmup = 0;        // Runs executed first and discarded
+    double target_ci = 0.0;         // Keep running until the CI half-width is below this % of the median, 0 disables it
+    uint32_t max_runs = 100;        // Upper bound for adaptive runs
+};
+
+inline auto median_of(std::vector<double> values) -> double {
+    if (values.empty()) {
+        return 0.0;
+    }
+
+    std::sort(values.begin(), values.end());
+    auto half = values.size() / 2;
+
+    return (values.size() % 2) ? values[half] : (values[half - 1] + values[half]) / 2.0;
+}
+
+// Linear interpolation between the closest ranks, values have to be sorted
+inline auto quantile_of(const std::vector<double>& sorted, double q) -> double {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+
+    auto position = q * (sorted.size() - 1);
+    auto lower = static_cast<size_t>(std::floor(position));
+    auto upper = std::min(lower + 1, sorted.size() - 1);
+
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower);
+}
+
+inline auto compute_statistics(const std::vector<RunResult>& runs) -> RunStatistics {
+    constexpr uint32_t NUM_RESAMPLES = 2000;
+
+    RunStatistics stats{};
+    std::vector<double> values;
+
+    for (auto& run : runs) {
+        values.push_back(static_cast<double>(run.value));
+    }
+
+    if (values.empty()) {
+        return stats;
+    }
+
+    double sum = 0.0;
+    for (auto value : values) {
+        sum += value;
+    }
+
+    stats.mean = sum / values.size();
+    stats.median = median_of(values);
+
+    // Sample standard deviation
+    double squares = 0.0;
+    for (auto value : values) {
+        squares += (value - stats.mean) * (value - stats.mean);
+    }
+
+    stats.stddev = values.size() > 1 ? std::sqrt(squares / (values.size() - 1)) : 0.0;
+
+    // Percentile bootstrap of the median, seeded so reruns of the same values agree
+    std::mt19937_64 rng(37);
+    std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+    std::vector<double> medians(NUM_RESAMPLES);
+    std::vector<double> sample(values.size());
+
+    for (auto& median : medians) {
+        for (auto& value : sample) {
+            value = values[pick(rng)];
+        }
+
+        median = median_of(sample);
+    }
+
+    std::sort(medians.begin(), medians.end());
+    stats.confidence = 0.95;
+    stats.ci_low = quantile_of(medians, (1.0 - stats.confidence) / 2.0);
+    stats.ci_high = quantile_of(medians, 1.0 - (1.0 - stats.confidence) / 2.0);
+    stats.ci_half_width_pct = stats.median > 0.0 ? 100.0 * (stats.ci_high - stats.ci_low) / 2.0 / stats.median : 0.0;
+
+    // Tukey's fences
+    auto sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    auto q1 = quantile_of(sorted, 0.25);
+    auto q3 = quantile_of(sorted, 0.75);
+    stats.outlier_low = q1 - 1.5 * (q3 - q1);
+    stats.outlier_high = q3 + 1.5 * (q3 - q1);
+
+    return stats;
+}
+
+// Runs warmup and measured iterations of run() and fills in the result's runs and statistics.
+// With a target CI, runs continue past num_runs until the median is precise enough (or max_runs is hit).
+template<typename F>
+inline auto run_iterations(BenchmarkResult& result, const RunSettings& settings, F&& run) -> void {
+    result.correct = true;
+    result.hash = 0;
+    result.runs.clear();
+
+    auto min_runs = std::max<uint32_t>(settings.num_runs, 1);
+    auto max_runs = settings.target_ci > 0.0 ? std::max(settings.max_runs, min_runs) : min_runs;
+
+    for (uint32_t i = 0; i < settings.num_warmup + max_runs; i++) {
+        auto warmup = i < settings.num_warmup;
+
+        if (warmup) {
+            std::cout << "Starting warmup " << (i + 1) << "/" << settings.num_warmup << std::endl;
+        } else {
+            std::cout << "Starting iteration " << (result.runs.size() + 1) << "/" << (max_runs > min_runs ? "<=" : "") << max_runs << std::endl;
+        }
+
+        auto run_result = run();
+
+        // The run's map is gone, its pools / arena go with it
+        MapHeap::get().release();
+
+        // Warmup runs still have to be correct
+        if (i == 0) {
+            result.hash = run_result.hash;
+        }
+
+        if (run_result.hash != result.hash) {
+            result.correct = false;
+        }
+
+        if (warmup) {
+            continue;
+        }
+
+        result.runs.push_back(run_result);
+
+        if (result.runs.size() >= min_runs && settings.target_ci > 0.0) {
+            auto stats = compute_statistics(result.runs);
+
+            if (stats.ci_half_width_pct <= settings.target_ci) {
+                break;
+            }
+        }
+    }
+
+    result.num_runs = static_cast<uint32_t>(result.runs.size());
+    result.num_warmup = settings.num_warmup;
+    result.stats = compute_statistics(result.runs);
+
+    result.total_value = 0;
+    result.min_value = std::numeric_limits<uint64_t>::max();
+    result.max_value = std::numeric_limits<uint64_t>::min();
+
+    for (auto& run_result : result.runs) {
+        run_result.outlier = run_result.value < result.stats.outlier_low || run_result.value > result.stats.outlier_high;
+        result.stats.num_outliers += run_result.outlier ? 1 : 0;
+
+        result.total_value += run_result.value;
+        result.min_value = std::min(result.min_value, run_result.value);
+        result.max_value = std::max(result.max_value, run_result.value);
+    }
+
+    result.avg_value = result.total_value / result.num_runs;
+    result.mean_value = static_cast<uint64_t>(result.stats.median);
+}
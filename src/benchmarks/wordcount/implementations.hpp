@@ -0,0 +1,39 @@
+#pragma once
+#include "libcuckoo.hpp"
+#include "stdmap.hpp"
+#include "tbbmap.hpp"
+#include "../registry.hpp"
+
+namespace WordCountBenchmark {
+    // Implementations selectable with --implementation, in the order "all" runs them
+    struct CuckooImpl {
+        using Map = CuckooMap;
+        static constexpr const char* name = "libcuckoo";
+        static constexpr const char* description = "libcuckoo";
+    };
+
+    struct TBBUnorderedImpl {
+        using Map = TBBUnorderedMap;
+        static constexpr const char* name = "tbb-unordered";
+        static constexpr const char* description = "TBB concurrent_unordered_map";
+    };
+
+    struct TBBHashImpl {
+        using Map = TBBHashMap;
+        static constexpr const char* name = "tbb-hash";
+        static constexpr const char* description = "TBB concurrent_hash_map";
+    };
+
+    struct STDBlockingImpl {
+        using Map = BlockingSTDMap;
+        static constexpr const char* name = "std-blocking";
+        static constexpr const char* description = "Blocking STD";
+    };
+
+    using Implementations = Registry<
+        CuckooImpl,
+        TBBUnorderedImpl,
+        TBBHashImpl,
+        STDBlockingImpl
+    >;
+}
@@ -13,21 +13,31 @@ namespace WordCountBenchmark {
                 }, def);
             }
 
-            inline KeyValues get_key_value_pairs() {
-                KeyValues kvs;
-                kvs.reserve(this->map.size());
+            // lock_table() takes every bucket lock, writers wait until the copy is done
+            static constexpr bool CONSISTENT_SNAPSHOT = true;
 
+            inline void snapshot(KeyValues& kvs) {
                 auto lt = map.lock_table();
+                kvs.reserve(lt.size());
+
                 for (auto& [key, value] : lt) {
                     kvs.push_back(std::make_pair(key, value));
                 }
+            }
 
+            inline KeyValues get_key_value_pairs() {
+                KeyValues kvs;
+                this->snapshot(kvs);
                 std::stable_sort(kvs.begin(), kvs.end());
 
                 return kvs;
             }
 
+            inline void introspect(MapStats& stats) {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            libcuckoo::cuckoohash_map<std::string_view, uint32_t> map;
+            libcuckoo::cuckoohash_map<std::string_view, uint32_t, std::hash<std::string_view>, std::equal_to<std::string_view>, MapAllocator<std::string_view, uint32_t>> map;
     };
 }
\ No newline at end of file
@@ -10,23 +10,32 @@ namespace WordCountBenchmark {
                 this->map[key] += 1;
             }
 
-            inline KeyValues get_key_value_pairs() {
-                std::lock_guard<std::mutex> guard(this->mtx);
+            // Copied under the map's mutex, writers wait until the copy is done
+            static constexpr bool CONSISTENT_SNAPSHOT = true;
 
-                KeyValues kvs;
+            inline void snapshot(KeyValues& kvs) {
+                std::lock_guard<std::mutex> guard(this->mtx);
                 kvs.reserve(this->map.size());
 
                 for (auto& [key, value] : this->map) {
                     kvs.push_back(std::make_pair(key, value));
                 }
+            }
 
+            inline KeyValues get_key_value_pairs() {
+                KeyValues kvs;
+                this->snapshot(kvs);
                 std::stable_sort(kvs.begin(), kvs.end());
 
                 return kvs;
             }
 
+            inline void introspect(MapStats& stats) {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            std::unordered_map<std::string_view, uint32_t> map;
+            std::unordered_map<std::string_view, uint32_t, std::hash<std::string_view>, std::equal_to<std::string_view>, MapAllocator<std::string_view, uint32_t>> map;
             std::mutex mtx;
     };
 }
\ No newline at end of file
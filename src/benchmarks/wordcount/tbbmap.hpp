@@ -10,21 +10,31 @@ namespace WordCountBenchmark {
                 this->map[key].fetch_and_increment();
             }
 
-            inline KeyValues get_key_value_pairs() {
-                KeyValues kvs;
+            // Iterating is safe while inserting, but entries inserted meanwhile may or may not show up
+            static constexpr bool CONSISTENT_SNAPSHOT = false;
+
+            inline void snapshot(KeyValues& kvs) {
                 kvs.reserve(this->map.size());
 
                 for (auto& [key, value] : this->map) {
                     kvs.push_back(std::make_pair(key, value));
                 }
+            }
 
+            inline KeyValues get_key_value_pairs() {
+                KeyValues kvs;
+                this->snapshot(kvs);
                 std::stable_sort(kvs.begin(), kvs.end());
 
                 return kvs;
             }
 
+            inline void introspect(MapStats& stats) {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            tbb::concurrent_unordered_map<std::string_view, tbb::atomic<uint32_t>, std::hash<std::string_view>> map;
+            tbb::concurrent_unordered_map<std::string_view, tbb::atomic<uint32_t>, std::hash<std::string_view>, std::equal_to<std::string_view>, MapAllocator<std::string_view, tbb::atomic<uint32_t>>> map;
     };
 
     class TBBHashMap : public WordCountMapInterface {
@@ -55,21 +65,32 @@ namespace WordCountBenchmark {
                 ac.release();
             }
 
-            inline KeyValues get_key_value_pairs() {
-                KeyValues kvs;
+            // TBB doesn't support traversal during inserts (it races on the segment table and bucket chains), so --readers
+            // rejects this map and snapshots are only taken once counting is done
+            static constexpr bool CONSISTENT_SNAPSHOT = true;
+
+            inline void snapshot(KeyValues& kvs) {
                 kvs.reserve(this->map.size());
 
                 for (auto& [key, value] : this->map) {
                     kvs.push_back(std::make_pair(key, value));
                 }
+            }
 
+            inline KeyValues get_key_value_pairs() {
+                KeyValues kvs;
+                this->snapshot(kvs);
                 std::stable_sort(kvs.begin(), kvs.end());
 
                 return kvs;
             }
 
+            inline void introspect(MapStats& stats) {
+                introspect_table(this->map, stats);
+            }
+
         private:
-            using MapType = tbb::concurrent_hash_map<std::string_view, uint32_t, StringViewHashCompare>;
+            using MapType = tbb::concurrent_hash_map<std::string_view, uint32_t, StringViewHashCompare, MapAllocator<std::string_view, uint32_t>>;
             MapType map;
     };
 }
\ No newline at end of file
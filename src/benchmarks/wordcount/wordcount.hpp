@@ -4,14 +4,53 @@
 #include <limits>
 #include <algorithm>
 #include <functional>
+#include <atomic>
+#include <optional>
 #include "interface.hpp"
-#include "../../utils/semaphore.hpp"
+#include "../../utils/barrier.hpp"
 #include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/latency_histogram.hpp"
 #include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
 
 namespace WordCountBenchmark {
     using WordFile = std::vector<std::string>;
 
+    // What the readers running next to the counting threads ask the map for
+    enum class SnapshotKind {
+        Full,           // A copy of every word and its count
+        TopK            // The k most frequent words, still from a full copy since none of the maps can do better
+    };
+
+    inline auto parse_snapshot_kind(const std::string& name) -> std::optional<SnapshotKind> {
+        if (name == "full") {
+            return SnapshotKind::Full;
+        } else if (name == "top-k") {
+            return SnapshotKind::TopK;
+        }
+
+        return {};
+    }
+
+    struct ReaderOptions {
+        uint32_t num_readers;           // 0 only counts, like before
+        SnapshotKind kind;
+        uint32_t top_k;
+    };
+
+    struct ReaderStats {
+        LatencyHistogram latencies;
+        uint64_t num_entries = 0;       // Summed over all snapshots
+        uint64_t checksum = 0;          // Keeps the top-k selection from being optimized away
+    };
+
     auto load_file(const std::string& path) -> std::optional<WordFile> {
         std::ifstream file(path);
 
@@ -30,12 +69,18 @@ namespace WordCountBenchmark {
     }
 
     template<typename T>
-    inline auto benchmark_count_part(Semaphore& semaphore, const WordFile& file, T& map, uint32_t start, uint32_t end) -> void {
+    inline auto benchmark_count_part(SpinBarrier& barrier, const WordFile& file, T& map, uint32_t start, uint32_t end, PerfTotals& perf, PhaseTimes& times, uint32_t thread) -> void {
+        PerfCounters counters;
+        uint64_t num_words = 0;
+
         // Wait for test start
-        semaphore.wait();
+        barrier.arrive_and_wait();
+        times.begin(thread);
+        counters.start();
 
         for (auto i = start; i < end; i++) {
             auto& line = file[i];
+            times.set_progress(thread, num_words);
 
             uint32_t word_start = 0;
             for (auto o = 0; o < line.size(); o++) {
@@ -51,6 +96,7 @@ namespace WordCountBenchmark {
                     }
 
                     map.increase_or_insert(std::string_view(line.c_str() + word_start, len), 1);
+                    num_words++;
                     word_start = o + 1;
                 }
             }
@@ -67,15 +113,46 @@ namespace WordCountBenchmark {
             // Empty word check
             if (len > 0) {
                 map.increase_or_insert(std::string_view(line.c_str() + word_start, len), 1);
+                num_words++;
             }
 
         }
+
+        counters.stop();
+        times.end(thread);
+        times.set_progress(thread, num_words);
+        perf.add(counters.read(), num_words);
     }
 
+    // Takes snapshots until the counting threads are done, each one timed from start to the finished copy (or top-k)
     template<typename T>
-    inline uint64_t hash_whole_map(T& map) {
+    inline auto snapshot_worker(SpinBarrier& barrier, T& map, const ReaderOptions& options, const std::atomic<bool>& done, ReaderStats& stats) -> void {
+        WordCountMapInterface::KeyValues kvs;
+
+        barrier.arrive_and_wait();
+
+        while (!done.load(std::memory_order_acquire)) {
+            auto start = get_timepoint();
+
+            kvs.clear();
+            map.snapshot(kvs);
+            stats.num_entries += kvs.size();
+
+            if (options.kind == SnapshotKind::TopK && !kvs.empty()) {
+                auto k = std::min<size_t>(options.top_k, kvs.size());
+                std::partial_sort(kvs.begin(), kvs.begin() + k, kvs.end(), [](auto& a, auto& b) { return a.second > b.second; });
+                stats.checksum += kvs.front().second;
+            }
+
+            stats.latencies.record(get_duration(start, get_timepoint()));
+        }
+    }
+
+    template<typename T>
+    inline uint64_t hash_whole_map(T& map, uint64_t& num_keys) {
         auto kvs = map.get_key_value_pairs();
         uint64_t hash = kvs.size();
+        num_keys = kvs.size();
 
         for (auto& [key, value] : kvs) {
             auto key_hash = std::hash<std::string_view>{}(key);
@@ -88,91 +165,117 @@ namespace WordCountBenchmark {
     }
 
     template<typename T>
-    inline auto benchmark_impl(const WordFile& file, uint32_t num_threads) -> RunResult {
+    inline auto benchmark_impl(const WordFile& file, const ReaderOptions& reader_options, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
         T map;
-        Semaphore sem;
+        SpinBarrier barrier(num_threads + reader_options.num_readers + 1);
+        PerfTotals perf;
+        PhaseTimes times(num_threads);
         
-        RunResult result;
+        RunResult result{};
         auto even_split = file.size() / num_threads;
-        std::vector<std::thread> threads;
-        threads.reserve(num_threads);
+
+        // Readers get the slots after the counting threads
+        std::atomic<bool> done = false;
+        std::vector<ReaderStats> reader_stats(reader_options.num_readers);
+        TaskGroup readers;
+
+        for (uint32_t i = 0; i < reader_options.num_readers; i++) {
+            readers.run(
+                num_threads + i,
+                &snapshot_worker<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(reader_options),
+                std::cref(done),
+                std::ref(reader_stats[i])
+            );
+        }
+
+        TaskGroup workers;
 
         for (auto i = 0; i < num_threads; i++) {
             auto start = i * even_split;
             auto end = (i == num_threads - 1) ? file.size() : ((i + 1) * even_split);
 
-            threads.emplace_back(
-                std::thread(
-                    &benchmark_count_part<T>,
-                    std::ref(sem),
-                    std::cref(file),
-                    std::ref(map),
-                    start,
-                    end
-                )
+            workers.run(
+                i,
+                &benchmark_count_part<T>,
+                std::ref(barrier),
+                std::cref(file),
+                std::ref(map),
+                start,
+                end,
+                std::ref(perf),
+                std::ref(times),
+                i
             );
         }
 
-        // Start timer
+        // Release threads, the timer starts the moment the last one arrived
         Timer t;
-        t.start();
+        barrier.arrive_and_wait();
+        t.start_at(barrier.get_release_timepoint());
 
-        // Wake up threads
-        sem.notify_all();
+        ThroughputSampler sampler(times);
+        sampler.start(t.get_start());
 
-        // Join all threads
-        for (auto& th : threads) {
-            th.join();
-        }
+        // Wait for all workers
+        workers.wait();
 
-        // End timer
+        // End timer, before the sampler thread is torn down
         t.end();
-
-        result.hash = hash_whole_map<T>(map);
+        sampler.stop();
+        done.store(true, std::memory_order_release);
+        readers.wait();
+        memory.finish();
+        introspect_map(map, result);
+
+        uint64_t num_keys = 0;
+        result.hash = hash_whole_map<T>(map, num_keys);
         result.value = t.get_duration();
+        times.report(result, "count", t);
+        sampler.report(result, "count");
+        perf.report(result);
+        report_memory(result, memory, num_keys);
+
+        // Counting throughput, lower with readers blocking the writers
+        result.metrics["ops_per_sec"] = t.get_duration() > 0 ? times.get_progress() * 1e9 / t.get_duration() : 0.0;
+
+        if (reader_options.num_readers > 0) {
+            LatencyHistogram latencies;
+            uint64_t num_entries = 0;
+
+            for (auto& stats : reader_stats) {
+                latencies.merge(stats.latencies);
+                num_entries += stats.num_entries;
+            }
+
+            latencies.report(result, "snapshot");
+            result.metrics["num_snapshots"] = latencies.get_count();
+            result.metrics["snapshots_per_sec"] = t.get_duration() > 0 ? latencies.get_count() * 1e9 / t.get_duration() : 0.0;
+            result.metrics["snapshot_entries_avg"] = latencies.get_count() > 0 ? static_cast<double>(num_entries) / latencies.get_count() : 0.0;
+            result.metrics["snapshot_consistent"] = T::CONSISTENT_SNAPSHOT ? 1.0 : 0.0;
+
+            std::cout << "Snapshots: " << latencies.get_count() << " (" << (T::CONSISTENT_SNAPSHOT ? "consistent" : "weakly consistent") << "), p50 "
+                << latencies.quantile(0.5) / 1000 << "us, p99 " << latencies.quantile(0.99) / 1000 << "us, counting at "
+                << static_cast<uint64_t>(result.metrics["ops_per_sec"]) << " words/s" << std::endl;
+        }
 
         return result;
     }
 
     template<typename T>
-    inline auto run_benchmark(std::string impl, const WordFile& file, uint32_t num_runs, uint32_t num_threads) -> BenchmarkResult {
+    inline auto run_benchmark(std::string impl, const WordFile& file, const ReaderOptions& reader_options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
         BenchmarkResult result{};
 
         result.impl = impl;
         result.value_unit = "ns";
-        result.correct = true;
-
-        result.num_runs = num_runs;
         result.num_threads = num_threads;
-        
-        result.total_value = 0;
-        result.min_value = std::numeric_limits<uint64_t>::max();
-        result.max_value = std::numeric_limits<uint64_t>::min();
-
-        result.hash = 0;
-
-        for (uint32_t i = 0; i < num_runs; i++) {
-            std::cout << "Starting iteration " << (i + 1) << "/" << num_runs << std::endl;
-            auto run_result = benchmark_impl<T>(file, num_threads);
-
-            if (i == 0) {
-                result.hash = run_result.hash;
-            }
-
-            if (run_result.hash != result.hash) {
-                result.correct = false;
-            }
-
-            result.runs.push_back(run_result);
-            
-            result.total_value += run_result.value;
-
-            result.min_value = std::min(result.min_value, run_result.value);
-            result.max_value = std::max(result.max_value, run_result.value);
-        }
 
-        result.avg_value = result.total_value / result.num_runs;
-        result.mean_value = result.runs[result.num_runs / 2].value;
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(file, reader_options, num_threads);
+        });
 
         return result;
     }
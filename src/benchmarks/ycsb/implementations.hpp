@@ -0,0 +1,60 @@
+#pragma once
+#include "libcuckoo.hpp"
+#include "stdmap.hpp"
+#include "tbbmap.hpp"
+#include "junction.hpp"
+#include "../registry.hpp"
+
+namespace YCSBBenchmark {
+    // Implementations selectable with --implementation, in the order "all" runs them
+    struct CuckooImpl {
+        template<typename K, typename V>
+        using Map = CuckooMap<K, V>;
+        static constexpr const char* name = "libcuckoo";
+        static constexpr const char* description = "libcuckoo";
+    };
+
+    struct TBBUnorderedImpl {
+        template<typename K, typename V>
+        using Map = TBBUnorderedMap<K, V>;
+        static constexpr const char* name = "tbb-unordered";
+        static constexpr const char* description = "TBB concurrent_unordered_map";
+    };
+
+    struct TBBHashImpl {
+        template<typename K, typename V>
+        using Map = TBBHashMap<K, V>;
+        static constexpr const char* name = "tbb-hash";
+        static constexpr const char* description = "TBB concurrent_hash_map";
+    };
+
+    struct STDBlockingImpl {
+        template<typename K, typename V>
+        using Map = STDMap<K, V>;
+        static constexpr const char* name = "std-blocking";
+        static constexpr const char* description = "Blocking STD";
+    };
+
+    struct JunctionGrampaImpl {
+        template<typename K, typename V>
+        using Map = JunctionMapGrampa<K, V>;
+        static constexpr const char* name = "junction-grampa";
+        static constexpr const char* description = "Junction ConcurrentMap_Grampa";
+    };
+
+    struct JunctionLeapfrogImpl {
+        template<typename K, typename V>
+        using Map = JunctionMapLeapfrog<K, V>;
+        static constexpr const char* name = "junction-leapfrog";
+        static constexpr const char* description = "Junction ConcurrentMap_Leapfrog";
+    };
+
+    using Implementations = Registry<
+        CuckooImpl,
+        TBBUnorderedImpl,
+        TBBHashImpl,
+        STDBlockingImpl,
+        JunctionGrampaImpl,
+        JunctionLeapfrogImpl
+    >;
+}
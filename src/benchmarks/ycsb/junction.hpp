@@ -0,0 +1,146 @@
+#pragma once
+#include "ycsb.hpp"
+#include "../../utils/seqlock.hpp"
+#include <junction/ConcurrentMap_Grampa.h>
+#include <junction/ConcurrentMap_Leapfrog.h>
+#include <mutex>
+#include <vector>
+
+namespace YCSBBenchmark {
+    // Junction only maps integers to integers (or pointers). 8 byte keys and values are stored as they are, keys shifted by 1
+    // (Junction reserves the key 0, values are never 0 or 1, see make_value). Larger entries are stored indirectly:
+    // the table maps the key's id to a heap allocated copy of the whole key and its (seqlocked) value.
+    template<typename MapType, typename K, typename V>
+    class JunctionMap {
+        public:
+            using Key = K;
+            using Value = V;
+
+            JunctionMap() = default;
+
+            ~JunctionMap() {
+                if constexpr (!INLINE) {
+                    for (typename MapType::Iterator iter(this->map); iter.isValid(); iter.next()) {
+                        heap_delete(reinterpret_cast<Entry*>(iter.getValue()));
+                    }
+
+                    for (auto entry : this->retired) {
+                        heap_delete(entry);
+                    }
+                }
+            }
+
+            JunctionMap(const JunctionMap&) = delete;
+            auto operator=(const JunctionMap&) -> JunctionMap& = delete;
+
+            auto read(const K& key, V& value) -> bool {
+                auto stored = this->map.get(key.id() + 1);
+                if (stored == 0) {
+                    return false;
+                }
+
+                if constexpr (INLINE) {
+                    value = V::from(stored);
+                    return true;
+                } else {
+                    auto entry = reinterpret_cast<Entry*>(stored);
+                    if (entry->key != key) {
+                        return false;
+                    }
+
+                    value = entry->value.load();
+                    return true;
+                }
+            }
+
+            // There is no conditional assign, an entry erased in between gets inserted again
+            auto update(const K& key, const V& value) -> bool {
+                auto mutator = this->map.find(key.id() + 1);
+                auto stored = mutator.getValue();
+                if (stored == 0) {
+                    return false;
+                }
+
+                if constexpr (INLINE) {
+                    mutator.exchangeValue(value.id());
+                } else {
+                    reinterpret_cast<Entry*>(stored)->value.store(value);
+                }
+
+                return true;
+            }
+
+            auto insert(const K& key, const V& value) -> void {
+                if constexpr (INLINE) {
+                    this->map.assign(key.id() + 1, value.id());
+                } else {
+                    auto mutator = this->map.insertOrFind(key.id() + 1);
+                    auto stored = mutator.getValue();
+
+                    if (stored != 0) {
+                        reinterpret_cast<Entry*>(stored)->value.store(value);
+                        return;
+                    }
+
+                    auto old = mutator.exchangeValue(reinterpret_cast<uint64_t>(heap_new<Entry>(key, value)));
+                    if (old != 0) {
+                        this->retire(reinterpret_cast<Entry*>(old));
+                    }
+                }
+            }
+
+            auto remove(const K& key) -> bool {
+                auto stored = this->map.erase(key.id() + 1);
+
+                if constexpr (!INLINE) {
+                    if (stored != 0) {
+                        this->retire(reinterpret_cast<Entry*>(stored));
+                    }
+                }
+
+                return stored != 0;
+            }
+
+            // Junction doesn't keep a count, only call this while no one else is using the map
+            auto get_num_entries() -> uint64_t {
+                uint64_t num_entries = 0;
+
+                for (typename MapType::Iterator iter(this->map); iter.isValid(); iter.next()) {
+                    num_entries++;
+                }
+
+                return num_entries;
+            }
+
+            // Junction doesn't expose its cells
+            auto introspect(MapStats&) -> void {
+            }
+
+        private:
+            static constexpr bool INLINE = sizeof(K) == 8 && sizeof(V) == 8;
+
+            struct Entry {
+                Entry(const K& key, const V& value) : key(key), value(value) {
+                }
+
+                K key;
+                Seqlocked<V> value;
+            };
+
+            // Readers may still hold a removed entry, they're only freed with the map
+            auto retire(Entry* entry) -> void {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->retired.push_back(entry);
+            }
+
+            MapType map;
+            std::mutex mtx;
+            std::vector<Entry*> retired;
+    };
+
+    template<typename K, typename V>
+    using JunctionMapGrampa = JunctionMap<junction::ConcurrentMap_Grampa<uint64_t, uint64_t>, K, V>;
+
+    template<typename K, typename V>
+    using JunctionMapLeapfrog = JunctionMap<junction::ConcurrentMap_Leapfrog<uint64_t, uint64_t>, K, V>;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "ycsb.hpp"
+#include <libcuckoo/cuckoohash_map.hh>
+
+namespace YCSBBenchmark {
+    template<typename K, typename V>
+    class CuckooMap {
+        public:
+            using Key = K;
+            using Value = V;
+
+            auto read(const K& key, V& value) -> bool {
+                return this->map.find(key, value);
+            }
+
+            auto update(const K& key, const V& value) -> bool {
+                return this->map.update_fn(key, [&value](V& current) {
+                    current = value;
+                });
+            }
+
+            auto insert(const K& key, const V& value) -> void {
+                this->map.insert_or_assign(key, value);
+            }
+
+            auto remove(const K& key) -> bool {
+                return this->map.erase(key);
+            }
+
+            auto get_num_entries() const -> uint64_t {
+                return this->map.size();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            libcuckoo::cuckoohash_map<K, V, std::hash<K>, std::equal_to<K>, MapAllocator<K, V>> map;
+    };
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "ycsb.hpp"
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace YCSBBenchmark {
+    template<typename K, typename V>
+    class STDMap {
+        public:
+            using Key = K;
+            using Value = V;
+
+            auto read(const K& key, V& value) -> bool {
+                std::shared_lock lock(this->mtx);
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                value = result->second;
+                return true;
+            }
+
+            auto update(const K& key, const V& value) -> bool {
+                std::unique_lock lock(this->mtx);
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                result->second = value;
+                return true;
+            }
+
+            auto insert(const K& key, const V& value) -> void {
+                std::unique_lock lock(this->mtx);
+                this->map.insert_or_assign(key, value);
+            }
+
+            auto remove(const K& key) -> bool {
+                std::unique_lock lock(this->mtx);
+                return this->map.erase(key) > 0;
+            }
+
+            auto get_num_entries() -> uint64_t {
+                std::shared_lock lock(this->mtx);
+                return this->map.size();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, MapAllocator<K, V>> map;
+            std::shared_mutex mtx;
+    };
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "ycsb.hpp"
+#include "../../utils/seqlock.hpp"
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_unordered_map.h>
+
+namespace YCSBBenchmark {
+    template<typename K, typename V>
+    class TBBHashMap {
+        public:
+            using Key = K;
+            using Value = V;
+
+            auto read(const K& key, V& value) -> bool {
+                typename MapType::const_accessor accessor;
+                if (!this->map.find(accessor, key)) {
+                    return false;
+                }
+
+                value = accessor->second;
+                return true;
+            }
+
+            auto update(const K& key, const V& value) -> bool {
+                typename MapType::accessor accessor;
+                if (!this->map.find(accessor, key)) {
+                    return false;
+                }
+
+                accessor->second = value;
+                return true;
+            }
+
+            auto insert(const K& key, const V& value) -> void {
+                typename MapType::accessor accessor;
+                this->map.insert(accessor, key);
+                accessor->second = value;
+            }
+
+            auto remove(const K& key) -> bool {
+                return this->map.erase(key);
+            }
+
+            auto get_num_entries() const -> uint64_t {
+                return this->map.size();
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            using MapType = tbb::concurrent_hash_map<K, V, tbb::tbb_hash_compare<K>, MapAllocator<K, V>>;
+            MapType map;
+    };
+
+    // concurrent_unordered_map can't erase concurrently, deleted entries are only marked as such.
+    // Values are replaced in place, under a per entry sequence lock.
+    template<typename K, typename V>
+    class TBBUnorderedMap {
+        public:
+            using Key = K;
+            using Value = V;
+
+            auto read(const K& key, V& value) -> bool {
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                auto slot = result->second.load();
+                value = slot.value;
+                return slot.live;
+            }
+
+            auto update(const K& key, const V& value) -> bool {
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                return result->second.modify([&](Slot& slot) {
+                    if (slot.live) {
+                        slot.value = value;
+                    }
+
+                    return slot.live;
+                });
+            }
+
+            auto insert(const K& key, const V& value) -> void {
+                auto result = this->map.emplace(key, Slot{ value, true });
+                if (!result.second) {
+                    result.first->second.store(Slot{ value, true });
+                }
+            }
+
+            auto remove(const K& key) -> bool {
+                auto result = this->map.find(key);
+                if (result == this->map.end()) {
+                    return false;
+                }
+
+                return result->second.modify([](Slot& slot) {
+                    auto live = slot.live;
+                    slot.live = false;
+                    return live;
+                });
+            }
+
+            // Deleted entries stay in the map, only call this while no one else is using it
+            auto get_num_entries() const -> uint64_t {
+                uint64_t num_entries = 0;
+
+                for (auto& [key, value] : this->map) {
+                    num_entries += value.load().live ? 1 : 0;
+                }
+
+                return num_entries;
+            }
+
+            auto introspect(MapStats& stats) -> void {
+                introspect_table(this->map, stats);
+            }
+
+        private:
+            struct Slot {
+                V value;
+                bool live;
+            };
+
+            tbb::concurrent_unordered_map<K, Seqlocked<Slot>, std::hash<K>, std::equal_to<K>, MapAllocator<K, Seqlocked<Slot>>> map;
+    };
+}
@@ -0,0 +1,463 @@
+#pragma once
+#include <string>
+#include <random>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <vector>
+#include "../benchmark.hpp"
+#include "../statistics.hpp"
+#include "../memory_report.hpp"
+#include "../../utils/map_introspection.hpp"
+#include "../../utils/zipf.hpp"
+#include "../../utils/barrier.hpp"
+#include "../../utils/timer.hpp"
+#include "../../utils/affinity.hpp"
+#include "../../utils/worker_pool.hpp"
+#include "../../utils/perf_counters.hpp"
+#include "../../utils/phase_times.hpp"
+#include "../../utils/throughput_sampler.hpp"
+#include "../../utils/pod.hpp"
+
+namespace YCSBBenchmark {
+    // Value ids are never 0 or 1, Junction reserves both for the 8 byte values it stores inline
+    inline auto make_value(uint64_t random) -> uint64_t {
+        return random | 2;
+    }
+
+    enum class Operation : uint8_t {
+        Read,
+        Update,
+        Insert,
+        Delete,
+        ReadModifyWrite,
+        Scan,
+        Count
+    };
+
+    constexpr uint32_t NUM_OPERATIONS = static_cast<uint32_t>(Operation::Count);
+
+    inline auto operation_name(uint32_t operation) -> const char* {
+        constexpr const char* names[NUM_OPERATIONS] = {
+            "read",
+            "update",
+            "insert",
+            "delete",
+            "rmw",
+            "scan"
+        };
+
+        return names[operation];
+    }
+
+    enum class KeyDistribution {
+        Uniform,        // Every loaded key is equally likely
+        Zipfian,        // Scrambled Zipfian over the loaded keys
+        Latest          // Zipfian over the most recently inserted keys
+    };
+
+    inline auto parse_key_distribution(const std::string& name) -> std::optional<KeyDistribution> {
+        if (name == "uniform") {
+            return KeyDistribution::Uniform;
+        } else if (name == "zipfian") {
+            return KeyDistribution::Zipfian;
+        } else if (name == "latest") {
+            return KeyDistribution::Latest;
+        }
+
+        return {};
+    }
+
+    inline auto key_distribution_name(KeyDistribution distribution) -> const char* {
+        switch (distribution) {
+            case KeyDistribution::Uniform: return "uniform";
+            case KeyDistribution::Latest: return "latest";
+            default: return "zipfian";
+        }
+    }
+
+    // Share of every operation (summing up to 1) and the workload's default key distribution
+    struct Workload {
+        std::string name;
+        double mix[NUM_OPERATIONS] = {};
+        KeyDistribution distribution = KeyDistribution::Zipfian;
+    };
+
+    // YCSB core workloads A-F, https://github.com/brianfrankcooper/YCSB/wiki/Core-Workloads
+    inline auto parse_workload(const std::string& name) -> std::optional<Workload> {
+        auto workload = [](const std::string& name, std::vector<std::pair<Operation, double>> mix, KeyDistribution distribution) {
+            Workload result{ name };
+
+            for (auto& [operation, share] : mix) {
+                result.mix[static_cast<uint32_t>(operation)] = share;
+            }
+
+            result.distribution = distribution;
+            return result;
+        };
+
+        if (name == "a") {
+            return workload("a", { { Operation::Read, 0.5 }, { Operation::Update, 0.5 } }, KeyDistribution::Zipfian);
+        } else if (name == "b") {
+            return workload("b", { { Operation::Read, 0.95 }, { Operation::Update, 0.05 } }, KeyDistribution::Zipfian);
+        } else if (name == "c") {
+            return workload("c", { { Operation::Read, 1.0 } }, KeyDistribution::Zipfian);
+        } else if (name == "d") {
+            return workload("d", { { Operation::Read, 0.95 }, { Operation::Insert, 0.05 } }, KeyDistribution::Latest);
+        } else if (name == "e") {
+            return workload("e", { { Operation::Scan, 0.95 }, { Operation::Insert, 0.05 } }, KeyDistribution::Zipfian);
+        } else if (name == "f") {
+            return workload("f", { { Operation::Read, 0.5 }, { Operation::ReadModifyWrite, 0.5 } }, KeyDistribution::Zipfian);
+        }
+
+        return {};
+    }
+
+    // Custom mix like "read=50,update=30,insert=10,delete=10", shares are normalized
+    inline auto parse_mix(const std::string& text) -> std::optional<Workload> {
+        Workload result{ "custom" };
+        std::stringstream ss(text);
+        std::string part;
+        double total = 0.0;
+
+        while (std::getline(ss, part, ',')) {
+            auto equals = part.find('=');
+            if (equals == std::string::npos) {
+                return {};
+            }
+
+            auto name = part.substr(0, equals);
+            uint32_t operation = 0;
+            while (operation < NUM_OPERATIONS && name != operation_name(operation)) {
+                operation++;
+            }
+
+            if (operation == NUM_OPERATIONS) {
+                return {};
+            }
+
+            try {
+                result.mix[operation] = std::max(std::stod(part.substr(equals + 1)), 0.0);
+            } catch (...) {
+                return {};
+            }
+
+            total += result.mix[operation];
+        }
+
+        if (total <= 0.0) {
+            return {};
+        }
+
+        for (auto& share : result.mix) {
+            share /= total;
+        }
+
+        return result;
+    }
+
+    struct BenchmarkOptions {
+        uint64_t seed;
+        uint64_t num_records;           // Keys loaded before the measured operations
+        uint64_t num_operations;        // Operations per run, split over all threads
+
+        Workload workload;
+        KeyDistribution distribution = KeyDistribution::Zipfian;
+        double zipf = 0.99;
+        uint32_t max_scan_length = 100;
+    };
+
+    // A pre-generated operation, keys of Latest accesses are resolved when executed
+    struct Request {
+        Operation operation;
+        uint32_t length;        // Keys read by a scan
+        uint64_t key;           // Key, or recency rank with the Latest distribution
+        uint64_t value;
+    };
+
+    // Zipfian distributions are expensive to set up, they are created once per benchmark and copied into every thread
+    struct KeyDistributions {
+        std::optional<ScrambledZipfDistribution> scrambled;
+        std::optional<ZipfDistribution> latest;
+
+        KeyDistributions(const BenchmarkOptions& options) {
+            if (options.distribution == KeyDistribution::Zipfian) {
+                this->scrambled.emplace(options.num_records, options.zipf);
+            } else if (options.distribution == KeyDistribution::Latest) {
+                this->latest.emplace(options.num_records, options.zipf);
+            }
+        }
+    };
+
+    // Generates a thread's operations up front, so drawing Zipfian keys isn't part of the measurement
+    inline auto generate_requests(const BenchmarkOptions& options, const KeyDistributions& distributions, uint64_t seed, uint64_t num_requests) -> std::vector<Request> {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> pick(0.0, 1.0);
+        std::uniform_int_distribution<uint64_t> uniform(0, options.num_records - 1);
+        std::uniform_int_distribution<uint32_t> scan_length(1, std::max<uint32_t>(options.max_scan_length, 1));
+
+        auto scrambled = distributions.scrambled;
+        auto latest = distributions.latest;
+
+        std::vector<Request> requests(num_requests);
+
+        for (auto& request : requests) {
+            auto p = pick(rng);
+            uint32_t operation = 0;
+
+            while (operation + 1 < NUM_OPERATIONS && p >= options.workload.mix[operation]) {
+                p -= options.workload.mix[operation];
+                operation++;
+            }
+
+            // Shares are rounded, fall back to the last operation the mix actually has
+            while (operation > 0 && options.workload.mix[operation] == 0.0) {
+                operation--;
+            }
+
+            request.operation = static_cast<Operation>(operation);
+            request.length = request.operation == Operation::Scan ? scan_length(rng) : 1;
+            request.value = make_value(rng());
+
+            if (scrambled) {
+                request.key = (*scrambled)(rng);
+            } else if (latest) {
+                request.key = (*latest)(rng);
+            } else {
+                request.key = uniform(rng);
+            }
+        }
+
+        return requests;
+    }
+
+    // Keys handed out to inserts, continuing after the loaded records
+    struct KeySpace {
+        alignas(64) std::atomic<uint64_t> next_key;
+        KeyDistribution distribution;
+
+        auto resolve(uint64_t key) const -> uint64_t {
+            if (this->distribution != KeyDistribution::Latest) {
+                return key;
+            }
+
+            // Rank 0 is the newest key
+            auto newest = this->next_key.load(std::memory_order_relaxed) - 1;
+            return newest - std::min(key, newest);
+        }
+    };
+
+    struct OperationCounts {
+        uint64_t operations[NUM_OPERATIONS] = {};
+        uint64_t misses = 0;        // Reads, updates and deletes of keys that weren't there
+        uint64_t checksum = 0;      // Sum of the values read, keeps reads from being optimized away
+    };
+
+    // Keys and values are T::Key and T::Value (Pods of the swept size), built from the request's ids
+    template<typename T>
+    inline auto execute(T& map, KeySpace& keys, const Request& request, OperationCounts& counts) -> void {
+        using K = typename T::Key;
+        using V = typename T::Value;
+
+        V value{};
+        auto key = keys.resolve(request.key);
+
+        switch (request.operation) {
+            case Operation::Read:
+                if (map.read(K::from(key), value)) {
+                    counts.checksum += value.id();
+                } else {
+                    counts.misses++;
+                }
+                break;
+            case Operation::Update:
+                if (!map.update(K::from(key), V::from(request.value))) {
+                    counts.misses++;
+                }
+                break;
+            case Operation::Insert:
+                map.insert(K::from(keys.next_key.fetch_add(1, std::memory_order_relaxed)), V::from(request.value));
+                break;
+            case Operation::Delete:
+                if (!map.remove(K::from(key))) {
+                    counts.misses++;
+                }
+                break;
+            case Operation::ReadModifyWrite: {
+                // Like YCSB, a read followed by a write, not an atomic update
+                auto pod_key = K::from(key);
+                if (map.read(pod_key, value)) {
+                    map.update(pod_key, V::from(make_value(value.id() + request.value)));
+                } else {
+                    counts.misses++;
+                }
+                break;
+            }
+            default:
+                // Hash maps have no order, a scan reads a range of consecutive keys instead
+                for (uint64_t i = 0; i < request.length; i++) {
+                    if (map.read(K::from(key + i), value)) {
+                        counts.checksum += value.id();
+                    }
+                }
+                break;
+        }
+
+        counts.operations[static_cast<uint32_t>(request.operation)]++;
+    }
+
+    template<typename T>
+    inline auto benchmark_worker(SpinBarrier& barrier, T& map, const BenchmarkOptions& options, const KeyDistributions& distributions, KeySpace& keys, uint64_t seed, uint32_t thread, uint32_t num_threads, PhaseTimes& load_times, PhaseTimes& run_times, PerfTotals& perf, OperationCounts& out_counts) -> void {
+        using K = typename T::Key;
+        using V = typename T::Value;
+
+        auto even_split = options.num_operations / num_threads;
+        auto num_requests = (thread == num_threads - 1) ? options.num_operations - thread * even_split : even_split;
+        auto requests = generate_requests(options, distributions, seed, num_requests);
+
+        // Load phase, every thread inserts a slice of the records
+        auto load_split = options.num_records / num_threads;
+        auto load_start = thread * load_split;
+        auto load_end = (thread == num_threads - 1) ? options.num_records : load_start + load_split;
+        std::mt19937_64 rng(~seed);
+
+        barrier.arrive_and_wait();
+        load_times.begin(thread);
+
+        for (auto key = load_start; key < load_end; key++) {
+            map.insert(K::from(key), V::from(make_value(rng())));
+            load_times.set_progress(thread, key - load_start);
+        }
+
+        load_times.end(thread);
+        load_times.set_progress(thread, load_end - load_start);
+
+        // Run phase, starts once every thread finished loading
+        PerfCounters counters;
+        OperationCounts counts;
+
+        barrier.arrive_and_wait();
+        run_times.begin(thread);
+        counters.start();
+
+        for (uint64_t i = 0; i < requests.size(); i++) {
+            execute(map, keys, requests[i], counts);
+            run_times.set_progress(thread, i);
+        }
+
+        counters.stop();
+        run_times.end(thread);
+        run_times.set_progress(thread, requests.size());
+        perf.add(counters.read(), requests.size());
+
+        out_counts = counts;
+    }
+
+    template<typename T>
+    inline auto benchmark_impl(const BenchmarkOptions& options, const KeyDistributions& distributions, uint32_t num_threads) -> RunResult {
+        MemoryProbe memory;
+        T map;
+        RunResult result{};
+
+        SpinBarrier barrier(num_threads + 1);
+        KeySpace keys{ { options.num_records }, options.distribution };
+        PerfTotals perf;
+        PhaseTimes load_times(num_threads);
+        PhaseTimes run_times(num_threads);
+        std::vector<OperationCounts> counts(num_threads);
+
+        TaskGroup workers;
+        for (uint32_t i = 0; i < num_threads; i++) {
+            workers.run(
+                i,
+                &benchmark_worker<T>,
+                std::ref(barrier),
+                std::ref(map),
+                std::cref(options),
+                std::cref(distributions),
+                std::ref(keys),
+                options.seed + i,
+                i,
+                num_threads,
+                std::ref(load_times),
+                std::ref(run_times),
+                std::ref(perf),
+                std::ref(counts[i])
+            );
+        }
+
+        // Load phase, ends when the last worker is done loading
+        Timer load;
+        barrier.arrive_and_wait();
+        load.start_at(barrier.get_release_timepoint());
+
+        // Run phase
+        Timer t;
+        barrier.arrive_and_wait();
+        load.end_at(barrier.get_release_timepoint());
+        t.start_at(barrier.get_release_timepoint());
+
+        ThroughputSampler sampler(run_times);
+        sampler.start(t.get_start());
+
+        workers.wait();
+        t.end();
+        sampler.stop();
+
+        result.hash = 0;        // Concurrent updates make the values read nondeterministic
+        result.value = t.get_duration();
+
+        load_times.report(result, "load", load);
+        run_times.report(result, "run", t);
+        result.metrics["load_ops_per_sec"] = load.get_duration() > 0 ? options.num_records * 1e9 / load.get_duration() : 0.0;
+        sampler.report(result, "run");
+
+        // Operations of the run phase
+        OperationCounts total;
+        for (auto& thread_counts : counts) {
+            for (uint32_t i = 0; i < NUM_OPERATIONS; i++) {
+                total.operations[i] += thread_counts.operations[i];
+            }
+
+            total.misses += thread_counts.misses;
+        }
+
+        for (uint32_t i = 0; i < NUM_OPERATIONS; i++) {
+            result.metrics[std::string("num_") + operation_name(i)] = total.operations[i];
+        }
+
+        result.metrics["num_misses"] = total.misses;
+        result.metrics["ops_per_sec"] = result.value > 0 ? options.num_operations * 1e9 / result.value : 0.0;
+
+        // An operation is a single request, a scan counts once
+        perf.report(result);
+
+        memory.finish();
+        report_memory(result, memory, map.get_num_entries());
+
+        introspect_map(map, result);
+
+        return result;
+    }
+
+    template<typename T>
+    inline auto run_benchmark(const std::string& impl, const BenchmarkOptions& options, const RunSettings& settings, uint32_t num_threads) -> BenchmarkResult {
+        BenchmarkResult result{};
+
+        result.impl = impl;
+        result.value_unit = "ns";
+        result.num_threads = num_threads;
+        result.key_size = sizeof(typename T::Key);
+        result.value_size = sizeof(typename T::Value);
+
+        KeyDistributions distributions(options);
+
+        run_iterations(result, settings, [&]() {
+            return benchmark_impl<T>(options, distributions, num_threads);
+        });
+
+        return result;
+    }
+}
@@ -4,9 +4,11 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <sstream>
 #include <optional>
 #include <thread>
 #include <cctype>
+#include <algorithm>
 
 #include "utils/json_serializer.hpp"
 #include "benchmarks/benchmarks.hpp"
@@ -22,17 +24,122 @@ auto write_file(const std::string& path, const std::string& text) -> void {
     file << text;
 }
 
-auto main_wordcount(int argc, const char** argv) -> BenchmarkResult {
+// Thread and dataset placement, performance counters and run statistics, shared by all benchmarks
+auto add_common_options(cxxopts::Options& options) -> void {
+    options.add_options()
+        ("affinity", "Thread pinning (none, compact, scatter, numa-node:N)", cxxopts::value<std::string>()->default_value("none"))
+        ("placement", "Dataset memory placement (first-touch, interleave)", cxxopts::value<std::string>()->default_value("first-touch"))
+        ("perf", "Collect hardware performance counters of the worker threads")
+        ("memory", "Measure the memory used by the map (allocated bytes, or RSS growth for Junction)")
+        ("introspect", "Report the map's load factor, bucket occupancy and probe lengths after every run")
+        ("allocator", "Where maps allocate nodes and values (std, pool, arena)", cxxopts::value<std::string>()->default_value("std"))
+        ("hugepages", "Back map storage and datasets with huge pages (off, thp, explicit)", cxxopts::value<std::string>()->default_value("off"))
+        ("fresh-threads", "Start new threads for every run and phase instead of reusing the persistent worker pool")
+        ("sample-ms", "Sample the throughput every N ms into a time series, 0 disables it", cxxopts::value<uint32_t>()->default_value("0"))
+        ("barrier", "How workers wait for the start of a run (spin, futex)", cxxopts::value<std::string>()->default_value("spin"))
+        ("warmup", "Number of discarded warmup runs", cxxopts::value<uint32_t>()->default_value("0"))
+        ("target-ci", "Keep running until the 95% CI of the median is within +-N% (runs is the minimum then), 0 disables it", cxxopts::value<double>()->default_value("0"))
+        ("max-runs", "Maximal number of runs with a target CI", cxxopts::value<uint32_t>()->default_value("100"));
+}
+
+auto configure_common_options(const cxxopts::ParseResult& result) -> RunSettings {
+    auto affinity_name = result["affinity"].as<std::string>();
+    auto affinity = parse_affinity(affinity_name);
+
+    if (!affinity) {
+        std::cerr << "Unknown affinity " << affinity_name << std::endl;
+        std::exit(-1);
+    }
+
+    auto placement_name = result["placement"].as<std::string>();
+    auto placement = parse_data_placement(placement_name);
+
+    if (!placement) {
+        std::cerr << "Unknown placement " << placement_name << std::endl;
+        std::exit(-1);
+    }
+
+    if (!thread_placement().configure(*affinity, *placement)) {
+        std::cerr << "No cpus available for affinity " << affinity_name << std::endl;
+        std::exit(-1);
+    }
+
+    auto barrier_name = result["barrier"].as<std::string>();
+    auto barrier_wait = parse_barrier_wait(barrier_name);
+
+    if (!barrier_wait) {
+        std::cerr << "Unknown barrier " << barrier_name << std::endl;
+        std::exit(-1);
+    }
+
+    auto allocator_name = result["allocator"].as<std::string>();
+    auto allocator = parse_heap_kind(allocator_name);
+
+    if (!allocator) {
+        std::cerr << "Unknown allocator " << allocator_name << std::endl;
+        std::exit(-1);
+    }
+
+    auto hugepages_name = result["hugepages"].as<std::string>();
+    auto hugepages = parse_huge_page_mode(hugepages_name);
+
+    if (!hugepages) {
+        std::cerr << "Unknown huge page mode " << hugepages_name << std::endl;
+        std::exit(-1);
+    }
+
+    PerfCounters::enabled().store(result.count("perf") > 0);
+    AllocationCounter::enabled().store(result.count("memory") > 0);
+    MapStats::enabled().store(result.count("introspect") > 0);
+    WorkerPool::enabled().store(result.count("fresh-threads") == 0);
+    ThroughputSampler::interval_ms().store(result["sample-ms"].as<uint32_t>());
+    SpinBarrier::default_wait().store(*barrier_wait);
+    MapHeap::kind().store(*allocator);
+    HugePages::mode().store(*hugepages);
+
+    std::cout << "Affinity: " << affinity_name << " (" << thread_placement().get_num_cpus() << " cpus), placement: " << placement_name << ", barrier: " << barrier_wait_name(SpinBarrier::default_wait().load()) << ", allocator: " << allocator_name << std::endl;
+
+    if (*hugepages != HugePageMode::Off) {
+        std::cout << "Huge pages: " << hugepages_name << " (" << HugePages::describe() << ")" << std::endl;
+    }
+
+    auto& clock = Clock::get();
+    std::cout << "Timer: " << clock.get_name() << " (" << (1.0 / clock.get_ns_per_tick()) << " ticks/ns)" << std::endl;
+
+    RunSettings settings{};
+    settings.num_runs = std::max<uint32_t>(result["runs"].as<uint32_t>(), 1);
+    settings.num_warmup = result["warmup"].as<uint32_t>();
+    settings.target_ci = result["target-ci"].as<double>();
+    settings.max_runs = result["max-runs"].as<uint32_t>();
+
+    return settings;
+}
+
+auto join(const std::vector<uint32_t>& values) -> std::string {
+    std::string result;
+
+    for (auto value : values) {
+        result += (result.empty() ? "" : ",") + std::to_string(value);
+    }
+
+    return result;
+}
+
+auto main_wordcount(int argc, const char** argv) -> std::vector<BenchmarkResult> {
     cxxopts::Options options("HashmapBenchmark wordcount", "Benchmark multiple concurrent hashmaps (WordCount benchmark)!");
 
     options.add_options()
-        ("t,threads", "Number of threads", cxxopts::value<uint32_t>()->default_value("16"))
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
         ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
         ("d,dataset", "Path to the used dataset", cxxopts::value<std::string>()->default_value("../data/test.ft.txt.out"))
-        ("i,implementation", "Map implementation to use", cxxopts::value<std::string>()->implicit_value("std"))
+        ("i,implementation", "Map implementation(s) to use (" + WordCountBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
+        ("readers", "Threads taking snapshots of the map while the words are counted", cxxopts::value<uint32_t>()->default_value("0"))
+        ("snapshot", "What the readers take (full, top-k)", cxxopts::value<std::string>()->default_value("full"))
+        ("top-k", "Number of most frequent words a top-k snapshot returns", cxxopts::value<uint32_t>()->default_value("10"))
         ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
         ("h,help", "Print usage");
 
+    add_common_options(options);
     options.allow_unrecognised_options();
     auto result = options.parse(argc, argv);
 
@@ -41,11 +148,12 @@ auto main_wordcount(int argc, const char** argv) -> BenchmarkResult {
         std::exit(0);
     }
 
-    auto num_threads = result["threads"].as<uint32_t>();
-    auto num_runs = result["runs"].as<uint32_t>();
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
     auto dataset_path = result["dataset"].as<std::string>();
 
-    auto file = WordCountBenchmark::load_file(dataset_path);
+    auto file = thread_placement().load([&]() { return WordCountBenchmark::load_file(dataset_path); });
 
     if (!file) {
         std::cout << "Dataset '" << dataset_path << "' does not exist, aborting!" << std::endl;
@@ -58,41 +166,58 @@ auto main_wordcount(int argc, const char** argv) -> BenchmarkResult {
         std::exit(-1);
     }
 
-    auto benchmark_impl_name = result["implementation"].as<std::string>();
+    auto impls = WordCountBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+    auto num_readers = result["readers"].as<uint32_t>();
 
-    std::cout << "Num threads: " << num_threads << std::endl;
-    std::cout << "Num runs: " << num_runs << std::endl;
+    // concurrent_hash_map can't be iterated while inserts run
+    if (num_readers > 0 && std::find(impls.begin(), impls.end(), "tbb-hash") != impls.end()) {
+        impls.erase(std::remove(impls.begin(), impls.end(), "tbb-hash"), impls.end());
+        std::cerr << "tbb-hash doesn't support snapshots while counting, left out with --readers" << std::endl;
 
-    if (benchmark_impl_name == "libcuckoo") {
-        std::cout << "Benchmarking libcuckoo!" << std::endl;
-        return WordCountBenchmark::run_benchmark<WordCountBenchmark::CuckooMap>(benchmark_impl_name, *file, num_runs, num_threads);
-    } else if (benchmark_impl_name == "tbb-unordered") {
-        std::cout << "Benchmarking TBB concurrent_unordered_map!" << std::endl;
-        return WordCountBenchmark::run_benchmark<WordCountBenchmark::TBBUnorderedMap>(benchmark_impl_name, *file, num_runs, num_threads);
-    } else if (benchmark_impl_name == "tbb-hash") {
-        std::cout << "Benchmarking TBB concurrent_hash_map!" << std::endl;
-        return WordCountBenchmark::run_benchmark<WordCountBenchmark::TBBHashMap>(benchmark_impl_name, *file, num_runs, num_threads);
-    } else if (benchmark_impl_name == "std-blocking") {
-        std::cout << "Benchmarking Blocking STD!" << std::endl;
-        return WordCountBenchmark::run_benchmark<WordCountBenchmark::BlockingSTDMap>(benchmark_impl_name, *file, num_runs, num_threads);
-    } else {
-        std::cerr << "Unknown implementation " << benchmark_impl_name << std::endl;
+        if (impls.empty()) {
+            std::exit(-1);
+        }
+    }
+
+    auto snapshot_name = result["snapshot"].as<std::string>();
+    auto snapshot_kind = WordCountBenchmark::parse_snapshot_kind(snapshot_name);
+
+    if (!snapshot_kind) {
+        std::cerr << "Unknown snapshot " << snapshot_name << std::endl;
         std::exit(-1);
     }
+
+    WordCountBenchmark::ReaderOptions reader_options{};
+    reader_options.num_readers = num_readers;
+    reader_options.kind = *snapshot_kind;
+    reader_options.top_k = std::max<uint32_t>(result["top-k"].as<uint32_t>(), 1);
+
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+
+    if (reader_options.num_readers > 0) {
+        std::cout << "Readers: " << reader_options.num_readers << " taking " << snapshot_name << " snapshots" << std::endl;
+    }
+
+    return run_matrix<WordCountBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+        using Entry = decltype(entry);
+        return WordCountBenchmark::run_benchmark<typename Entry::Map>(Entry::name, *file, reader_options, run_settings, num_threads);
+    });
 }
 
-auto main_hashjoin(int argc, const char** argv) -> BenchmarkResult {
+auto main_hashjoin(int argc, const char** argv) -> std::vector<BenchmarkResult> {
     cxxopts::Options options("HashmapBenchmark hashjoin", "Benchmark multiple concurrent hashmaps (HashJoin benchmark)!");
 
     options.add_options()
-        ("t,threads", "Number of threads", cxxopts::value<uint32_t>()->default_value("16"))
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
         ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
         ("a,dataseta", "Path to the used dataset A", cxxopts::value<std::string>()->default_value("../data/hash_join_smaller.txt"))
         ("b,datasetb", "Path to the used dataset B", cxxopts::value<std::string>()->default_value("../data/hash_join_larger.txt"))
         ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
-        ("i,implementation", "Map implementation to use", cxxopts::value<std::string>()->implicit_value("std-blocking"))
+        ("i,implementation", "Map implementation(s) to use (" + HashJoinBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
         ("h,help", "Print usage");
 
+    add_common_options(options);
     options.allow_unrecognised_options();
     auto result = options.parse(argc, argv);
 
@@ -101,58 +226,57 @@ auto main_hashjoin(int argc, const char** argv) -> BenchmarkResult {
         std::exit(0);
     }
 
-    auto num_threads = result["threads"].as<uint32_t>();
-    auto num_runs = result["runs"].as<uint32_t>();
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
     auto dataset_a_path = result["dataseta"].as<std::string>();
     auto dataset_b_path = result["datasetb"].as<std::string>();
 
-    auto dataset_a = HashJoinBenchmark::load_dataset_a(dataset_a_path);
-    auto dataset_b = HashJoinBenchmark::load_dataset_b(dataset_b_path);
+    auto dataset_a = thread_placement().load([&]() { return HashJoinBenchmark::load_dataset_a(dataset_a_path); });
+    auto dataset_b = thread_placement().load([&]() { return HashJoinBenchmark::load_dataset_b(dataset_b_path); });
 
-    auto benchmark_impl_name = result["implementation"].as<std::string>();
+    auto impls = HashJoinBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
 
-    std::cout << "Num threads: " << num_threads << std::endl;
-    std::cout << "Num runs: " << num_runs << std::endl;
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
     std::cout << "Num smaller: " << dataset_a.size() << std::endl;
     std::cout << "Num larger:  " << dataset_b.size() << std::endl;
 
-    if (benchmark_impl_name == "libcuckoo") {
-        std::cout << "Benchmarking libcuckoo!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::CuckooMap>("libcuckoo", dataset_a, dataset_b, num_runs, num_threads);
-    } else if (benchmark_impl_name == "tbb-unordered") {
-        std::cout << "Benchmarking TBB concurrent_unordered_map!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::TBBUnorderedMap>("tbb-unordered", dataset_a, dataset_b, num_runs, num_threads);
-    } else if (benchmark_impl_name == "tbb-hash") {
-        std::cout << "Benchmarking TBB concurrent_hash_map!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::TBBHashMap>("tbb-hash", dataset_a, dataset_b, num_runs, num_threads);
-    } else if (benchmark_impl_name == "std-blocking") {
-        std::cout << "Benchmarking Blocking STD!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::STDMap>("std-blocking", dataset_a, dataset_b, num_runs, num_threads);
-    } else if (benchmark_impl_name == "junction-grampa") {
-        std::cout << "Benchmarking Junction ConcurrentMap_Grampa!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::JunctionMapGrampa>("junction-grampa", dataset_a, dataset_b, num_runs, num_threads);
-    } else if (benchmark_impl_name == "junction-leapfrog") {
-        std::cout << "Benchmarking Junction ConcurrentMap_Leapfrog!" << std::endl;
-        return HashJoinBenchmark::run_benchmark<HashJoinBenchmark::JunctionMapLeapfrog>("junction-leapfrog", dataset_a, dataset_b, num_runs, num_threads);
-    } else {
-        std::cerr << "Unknown implementation " << benchmark_impl_name << std::endl;
-        std::exit(-1);
-    }
+    return run_matrix<HashJoinBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+        using Entry = decltype(entry);
+        return HashJoinBenchmark::run_benchmark<typename Entry::Map>(Entry::name, dataset_a, dataset_b, run_settings, num_threads);
+    });
 }
 
-auto main_cache(int argc, const char** argv) -> BenchmarkResult {
+auto main_cache(int argc, const char** argv) -> std::vector<BenchmarkResult> {
     cxxopts::Options options("HashmapBenchmark hashjoin", "Benchmark multiple concurrent hashmaps (Cache benchmark)!");
 
     options.add_options()
-        ("t,threads", "Number of threads", cxxopts::value<uint32_t>()->default_value("16"))
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
         ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
         ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
-        ("i,implementation", "Map implementation to use", cxxopts::value<std::string>()->implicit_value("std-blocking"))
+        ("i,implementation", "Map implementation(s) to use (" + CacheBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
         ("s,seed", "Random seed to use", cxxopts::value<uint64_t>()->default_value("37"))
         ("l,limit", "Time limit for this benchmark (ms)", cxxopts::value<uint64_t>()->default_value("30000"))
         ("c,capacity", "Map capacity (affects number of max indices)", cxxopts::value<uint64_t>()->default_value("500000"))
+        ("e,eviction", "Eviction strategy (cleaner, partitioned, sampled)", cxxopts::value<std::string>()->default_value("cleaner"))
+        ("cleaners", "Number of cleaner threads for partitioned eviction", cxxopts::value<uint32_t>()->default_value("4"))
+        ("samples", "Number of keys sampled per inline eviction", cxxopts::value<uint32_t>()->default_value("5"))
+        ("ttl", "TTL distribution (none, fixed, uniform, exponential)", cxxopts::value<std::string>()->default_value("none"))
+        ("ttl-ms", "Mean entry TTL (ms)", cxxopts::value<uint64_t>()->default_value("1000"))
+        ("expiry", "Expiry strategy (lazy, wheel)", cxxopts::value<std::string>()->default_value("lazy"))
+        ("value-min", "Minimal value size (bytes)", cxxopts::value<uint32_t>()->default_value("64"))
+        ("value-max", "Maximal value size (bytes), 0 disables values", cxxopts::value<uint32_t>()->default_value("0"))
+        ("capacity-bytes", "Map capacity in bytes, used instead of capacity with values", cxxopts::value<uint64_t>()->default_value("268435456"))
+        ("sizes", "Fixed value sizes (bytes) to sweep, each run like --value-min=N --value-max=N", cxxopts::value<std::vector<uint32_t>>())
+        ("backend-latency", "Latency of the simulated backend fetched on every miss (ns), 0 disables it", cxxopts::value<uint64_t>()->default_value("0"))
+        ("backend-wait", "How the backend waits (busy, park)", cxxopts::value<std::string>()->default_value("busy"))
+        ("coalesce", "Coalesce concurrent misses on the same key into a single backend fetch")
+        ("zipf", "Zipfian key popularity (theta), 0 for uniform", cxxopts::value<double>()->default_value("0"))
+        ("b,batch", "Keys per batched (multi-get) access, 1 for single accesses", cxxopts::value<uint32_t>()->default_value("1"))
         ("h,help", "Print usage");
 
+    add_common_options(options);
     options.allow_unrecognised_options();
     auto result = options.parse(argc, argv);
 
@@ -161,39 +285,464 @@ auto main_cache(int argc, const char** argv) -> BenchmarkResult {
         std::exit(0);
     }
 
-    auto num_threads = result["threads"].as<uint32_t>();
-    auto num_runs = result["runs"].as<uint32_t>();
-    auto seed = result["seed"].as<uint64_t>();
-    auto time_limit = result["limit"].as<uint64_t>();
-    auto capacity = result["capacity"].as<uint64_t>();
-
-    auto benchmark_impl_name = result["implementation"].as<std::string>();
-
-    std::cout << "Num threads: " << num_threads << std::endl;
-    std::cout << "Num runs: " << num_runs << std::endl;
-    std::cout << "Seed: " << seed << std::endl;
-    std::cout << "Timeout: " << time_limit << std::endl;
-    std::cout << "Capacity: " << capacity << std::endl;
-
-    if (benchmark_impl_name == "libcuckoo") {
-        std::cout << "Benchmarking libcuckoo!" << std::endl;
-        return CacheBenchmark::run_benchmark<CacheBenchmark::CuckooMap>("libcuckoo", seed, time_limit, capacity, num_runs, num_threads);
-    } else if (benchmark_impl_name == "tbb-hash") {
-        std::cout << "Benchmarking TBB concurrent_hash_map!" << std::endl;
-        return CacheBenchmark::run_benchmark<CacheBenchmark::TBBHashMap>("tbb-hash", seed, time_limit, capacity, num_runs, num_threads);
-    } else if (benchmark_impl_name == "std-blocking") {
-        std::cout << "Benchmarking Blocking STD!" << std::endl;
-        return CacheBenchmark::run_benchmark<CacheBenchmark::STDMap>("std-blocking", seed, time_limit, capacity, num_runs, num_threads);
-    } else if (benchmark_impl_name == "junction-grampa") {
-        std::cout << "Benchmarking Junction ConcurrentMap_Grampa!" << std::endl;
-        return CacheBenchmark::run_benchmark<CacheBenchmark::JunctionMapGrampa>("junction-grampa", seed, time_limit, capacity, num_runs, num_threads);
-    } else if (benchmark_impl_name == "junction-leapfrog") {
-        std::cout << "Benchmarking Junction ConcurrentMap_Leapfrog!" << std::endl;
-        return CacheBenchmark::run_benchmark<CacheBenchmark::JunctionMapLeapfrog>("junction-leapfrog", seed, time_limit, capacity, num_runs, num_threads);
-    } else {
-        std::cerr << "Unknown implementation " << benchmark_impl_name << std::endl;
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
+
+    CacheBenchmark::BenchmarkOptions benchmark_options{};
+    benchmark_options.seed = result["seed"].as<uint64_t>();
+    benchmark_options.time_limit = result["limit"].as<uint64_t>();
+    benchmark_options.map_capacity = result["capacity"].as<uint64_t>();
+    benchmark_options.num_cleaners = result["cleaners"].as<uint32_t>();
+    benchmark_options.num_samples = std::max<uint32_t>(result["samples"].as<uint32_t>(), 1);
+
+    auto eviction_name = result["eviction"].as<std::string>();
+    auto eviction = CacheBenchmark::parse_eviction_policy(eviction_name);
+
+    if (!eviction) {
+        std::cerr << "Unknown eviction strategy " << eviction_name << std::endl;
+        std::exit(-1);
+    }
+
+    benchmark_options.eviction = *eviction;
+
+    auto ttl_name = result["ttl"].as<std::string>();
+    auto ttl = CacheBenchmark::parse_ttl_distribution(ttl_name);
+
+    if (!ttl) {
+        std::cerr << "Unknown TTL distribution " << ttl_name << std::endl;
+        std::exit(-1);
+    }
+
+    auto expiry_name = result["expiry"].as<std::string>();
+    auto expiry = CacheBenchmark::parse_expiry_policy(expiry_name);
+
+    if (!expiry) {
+        std::cerr << "Unknown expiry strategy " << expiry_name << std::endl;
+        std::exit(-1);
+    }
+
+    benchmark_options.ttl = *ttl;
+    benchmark_options.ttl_ms = result["ttl-ms"].as<uint64_t>();
+    benchmark_options.expiry = *expiry;
+
+    benchmark_options.value_min = result["value-min"].as<uint32_t>();
+    benchmark_options.value_max = result["value-max"].as<uint32_t>();
+    benchmark_options.capacity_bytes = result["capacity-bytes"].as<uint64_t>();
+
+    auto backend_wait_name = result["backend-wait"].as<std::string>();
+    auto backend_wait = CacheBenchmark::parse_backend_wait(backend_wait_name);
+
+    if (!backend_wait) {
+        std::cerr << "Unknown backend wait " << backend_wait_name << std::endl;
+        std::exit(-1);
+    }
+
+    benchmark_options.backend_latency_ns = result["backend-latency"].as<uint64_t>();
+    benchmark_options.backend_wait = *backend_wait;
+    benchmark_options.coalesce = result.count("coalesce") > 0;
+    benchmark_options.zipf = result["zipf"].as<double>();
+    benchmark_options.batch_size = std::max<uint32_t>(result["batch"].as<uint32_t>(), 1);
+
+    if (benchmark_options.zipf < 0.0 || benchmark_options.zipf >= 1.0) {
+        std::cerr << "Zipfian theta has to be in [0, 1), 0 for uniform" << std::endl;
+        std::exit(-1);
+    }
+
+    // Without a sweep, the single "size" is whatever --value-min / --value-max select
+    std::vector<uint32_t> sizes = { 0 };
+    if (result.count("sizes") > 0) {
+        sizes = result["sizes"].as<std::vector<uint32_t>>();
+    }
+
+    for (auto size : sizes) {
+        if (std::max(size, benchmark_options.value_max) + sizeof(CacheBenchmark::Payload) > SlabAllocator::MAX_CHUNK) {
+            std::cerr << "Values can be at most " << (SlabAllocator::MAX_CHUNK - sizeof(CacheBenchmark::Payload)) << " bytes" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    auto impls = CacheBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+    std::cout << "Seed: " << benchmark_options.seed << std::endl;
+    std::cout << "Timeout: " << benchmark_options.time_limit << std::endl;
+    std::cout << "Capacity: " << benchmark_options.map_capacity << std::endl;
+    std::cout << "Eviction: " << eviction_name << std::endl;
+    std::cout << "Batch size: " << benchmark_options.batch_size << std::endl;
+    if (benchmark_options.value_max > 0) {
+        std::cout << "Values: " << benchmark_options.value_min << "-" << benchmark_options.value_max << "B (capacity: " << benchmark_options.capacity_bytes << "B)" << std::endl;
+    }
+
+    if (benchmark_options.backend_latency_ns > 0) {
+        std::cout << "Backend: " << benchmark_options.backend_latency_ns << "ns (" << backend_wait_name << (benchmark_options.coalesce ? ", coalesced" : "") << ")" << std::endl;
+    }
+
+    std::cout << "TTL: " << ttl_name << " (" << benchmark_options.ttl_ms << "ms, " << expiry_name << " expiry)" << std::endl;
+
+    std::vector<BenchmarkResult> results;
+
+    for (auto size : sizes) {
+        if (size > 0) {
+            benchmark_options.value_min = size;
+            benchmark_options.value_max = size;
+            std::cout << "Value size: " << size << " bytes" << std::endl;
+        }
+
+        auto size_results = run_matrix<CacheBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+            using Entry = decltype(entry);
+            return CacheBenchmark::run_benchmark<typename Entry::Map>(Entry::name, benchmark_options, run_settings, num_threads);
+        });
+
+        // Keys are always 8 byte integers, values live in the slab (indirectly) for every map
+        for (auto& size_result : size_results) {
+            if (size > 0) {
+                size_result.key_size = sizeof(uint64_t);
+                size_result.value_size = size;
+            }
+        }
+
+        results.insert(results.end(), size_results.begin(), size_results.end());
+    }
+
+    return results;
+}
+
+auto main_ycsb(int argc, const char** argv) -> std::vector<BenchmarkResult> {
+    cxxopts::Options options("HashmapBenchmark ycsb", "Benchmark multiple concurrent hashmaps (YCSB benchmark)!");
+
+    options.add_options()
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
+        ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
+        ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
+        ("i,implementation", "Map implementation(s) to use (" + YCSBBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
+        ("s,seed", "Random seed to use", cxxopts::value<uint64_t>()->default_value("37"))
+        ("w,workload", "YCSB core workload (a, b, c, d, e, f) or custom", cxxopts::value<std::string>()->default_value("a"))
+        ("mix", "Operation mix of the custom workload, e.g. read=50,update=30,insert=10,delete=10 (read, update, insert, delete, rmw, scan)", cxxopts::value<std::string>()->default_value("read=50,update=50"))
+        ("distribution", "Key distribution (uniform, zipfian, latest), defaults to the workload's", cxxopts::value<std::string>())
+        ("zipf", "Zipfian skew (theta) of the zipfian and latest distributions", cxxopts::value<double>()->default_value("0.99"))
+        ("records", "Number of records loaded before the operations", cxxopts::value<uint64_t>()->default_value("1000000"))
+        ("operations", "Number of operations per run", cxxopts::value<uint64_t>()->default_value("10000000"))
+        ("scan-length", "Maximal number of keys read by a scan", cxxopts::value<uint32_t>()->default_value("100"))
+        ("sizes", "Bytes per key and per value (8, 16, 32, 64, 128, 256), a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("8"))
+        ("h,help", "Print usage");
+
+    add_common_options(options);
+    options.allow_unrecognised_options();
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
+
+    YCSBBenchmark::BenchmarkOptions benchmark_options{};
+    benchmark_options.seed = result["seed"].as<uint64_t>();
+    benchmark_options.num_records = result["records"].as<uint64_t>();
+    benchmark_options.num_operations = result["operations"].as<uint64_t>();
+    benchmark_options.zipf = result["zipf"].as<double>();
+    benchmark_options.max_scan_length = std::max<uint32_t>(result["scan-length"].as<uint32_t>(), 1);
+
+    auto workload_name = result["workload"].as<std::string>();
+    auto workload = workload_name == "custom"
+        ? YCSBBenchmark::parse_mix(result["mix"].as<std::string>())
+        : YCSBBenchmark::parse_workload(workload_name);
+
+    if (!workload) {
+        std::cerr << "Unknown workload " << workload_name << " or invalid operation mix" << std::endl;
+        std::exit(-1);
+    }
+
+    benchmark_options.workload = *workload;
+    benchmark_options.distribution = workload->distribution;
+
+    if (result.count("distribution") > 0) {
+        auto distribution_name = result["distribution"].as<std::string>();
+        auto distribution = YCSBBenchmark::parse_key_distribution(distribution_name);
+
+        if (!distribution) {
+            std::cerr << "Unknown key distribution " << distribution_name << std::endl;
+            std::exit(-1);
+        }
+
+        benchmark_options.distribution = *distribution;
+    }
+
+    if (benchmark_options.num_records == 0) {
+        std::cerr << "At least one record has to be loaded" << std::endl;
+        std::exit(-1);
+    }
+
+    // Theta is unused by the uniform distribution
+    auto skewed = benchmark_options.distribution != YCSBBenchmark::KeyDistribution::Uniform;
+
+    if (skewed && (benchmark_options.zipf <= 0.0 || benchmark_options.zipf >= 1.0)) {
+        std::cerr << "Zipfian theta has to be in (0, 1) for the zipfian and latest distributions" << std::endl;
         std::exit(-1);
     }
+
+    auto sizes = result["sizes"].as<std::vector<uint32_t>>();
+
+    for (auto size : sizes) {
+        if (!is_pod_size(size)) {
+            std::cerr << "Unsupported key / value size " << size << ", has to be one of 8, 16, 32, 64, 128 or 256" << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    auto impls = YCSBBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+    std::cout << "Seed: " << benchmark_options.seed << std::endl;
+    std::cout << "Workload: " << workload_name << " (";
+    for (uint32_t operation = 0; operation < YCSBBenchmark::NUM_OPERATIONS; operation++) {
+        if (benchmark_options.workload.mix[operation] > 0.0) {
+            std::cout << YCSBBenchmark::operation_name(operation) << "=" << benchmark_options.workload.mix[operation] * 100.0 << "% ";
+        }
+    }
+    std::cout << ")" << std::endl;
+    std::cout << "Distribution: " << YCSBBenchmark::key_distribution_name(benchmark_options.distribution);
+    if (skewed) {
+        std::cout << " (theta " << benchmark_options.zipf << ")";
+    }
+    std::cout << std::endl;
+    std::cout << "Records: " << benchmark_options.num_records << ", operations: " << benchmark_options.num_operations << std::endl;
+    std::cout << "Key / value sizes: " << join(sizes) << std::endl;
+
+    // Every size is its own matrix of implementations and thread counts
+    std::vector<BenchmarkResult> results;
+
+    for (auto size : sizes) {
+        visit_pod_size(size, [&](auto pod_size) {
+            using Data = Pod<decltype(pod_size)::value>;
+
+            std::cout << "Key / value size: " << size << " bytes" << std::endl;
+
+            auto size_results = run_matrix<YCSBBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+                using Entry = decltype(entry);
+                return YCSBBenchmark::run_benchmark<typename Entry::template Map<Data, Data>>(Entry::name, benchmark_options, run_settings, num_threads);
+            });
+
+            results.insert(results.end(), size_results.begin(), size_results.end());
+        });
+    }
+
+    return results;
+}
+
+auto main_grow(int argc, const char** argv) -> std::vector<BenchmarkResult> {
+    cxxopts::Options options("HashmapBenchmark grow", "Benchmark multiple concurrent hashmaps (Grow benchmark)!");
+
+    options.add_options()
+        ("t,threads", "Number of inserting threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
+        ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
+        ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
+        ("i,implementation", "Map implementation(s) to use (" + GrowBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
+        ("s,seed", "Random seed to use", cxxopts::value<uint64_t>()->default_value("37"))
+        ("n,entries", "Number of entries inserted into the empty map", cxxopts::value<uint64_t>()->default_value("10000000"))
+        ("readers", "Number of threads reading while the map grows", cxxopts::value<uint32_t>()->default_value("4"))
+        ("stall-us", "Operations taking at least this long count as stalls (us)", cxxopts::value<uint64_t>()->default_value("100"))
+        ("h,help", "Print usage");
+
+    add_common_options(options);
+    options.allow_unrecognised_options();
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
+
+    GrowBenchmark::BenchmarkOptions benchmark_options{};
+    benchmark_options.seed = result["seed"].as<uint64_t>();
+    benchmark_options.num_entries = result["entries"].as<uint64_t>();
+    benchmark_options.num_readers = result["readers"].as<uint32_t>();
+    benchmark_options.stall_ns = result["stall-us"].as<uint64_t>() * 1000;
+
+    auto impls = GrowBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+
+    std::cout << "Num threads: " << join(thread_counts) << " (+" << benchmark_options.num_readers << " readers)" << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+    std::cout << "Entries: " << benchmark_options.num_entries << std::endl;
+    std::cout << "Stall threshold: " << benchmark_options.stall_ns / 1000 << "us" << std::endl;
+
+    return run_matrix<GrowBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+        using Entry = decltype(entry);
+        return GrowBenchmark::run_benchmark<typename Entry::Map>(Entry::name, benchmark_options, run_settings, num_threads);
+    });
+}
+
+auto main_churn(int argc, const char** argv) -> std::vector<BenchmarkResult> {
+    cxxopts::Options options("HashmapBenchmark churn", "Benchmark multiple concurrent hashmaps (Churn benchmark)!");
+
+    options.add_options()
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
+        ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("1"))
+        ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
+        ("i,implementation", "Map implementation(s) to use (" + ChurnBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
+        ("s,seed", "Random seed to use", cxxopts::value<uint64_t>()->default_value("37"))
+        ("live", "Number of live entries kept in the map", cxxopts::value<uint64_t>()->default_value("1000000"))
+        ("l,limit", "Churn duration of a run (ms)", cxxopts::value<uint64_t>()->default_value("600000"))
+        ("window-ms", "Length of a reported window (ms)", cxxopts::value<uint64_t>()->default_value("10000"))
+        ("h,help", "Print usage");
+
+    add_common_options(options);
+    options.allow_unrecognised_options();
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
+
+    ChurnBenchmark::BenchmarkOptions benchmark_options{};
+    benchmark_options.seed = result["seed"].as<uint64_t>();
+    benchmark_options.num_live = result["live"].as<uint64_t>();
+    benchmark_options.duration_ms = std::max<uint64_t>(result["limit"].as<uint64_t>(), 1);
+    benchmark_options.window_ms = std::min(std::max<uint64_t>(result["window-ms"].as<uint64_t>(), 1), benchmark_options.duration_ms);
+
+    auto impls = ChurnBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+    std::cout << "Seed: " << benchmark_options.seed << std::endl;
+    std::cout << "Live entries: " << benchmark_options.num_live << std::endl;
+    std::cout << "Duration: " << benchmark_options.duration_ms << "ms (" << benchmark_options.window_ms << "ms windows)" << std::endl;
+
+    return run_matrix<ChurnBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+        using Entry = decltype(entry);
+        return ChurnBenchmark::run_benchmark<typename Entry::Map>(Entry::name, benchmark_options, run_settings, num_threads);
+    });
+}
+
+auto main_aggregate(int argc, const char** argv) -> std::vector<BenchmarkResult> {
+    cxxopts::Options options("HashmapBenchmark aggregate", "Benchmark multiple concurrent hashmaps (Aggregate benchmark)!");
+
+    options.add_options()
+        ("t,threads", "Number of threads, a comma separated list sweeps them", cxxopts::value<std::vector<uint32_t>>()->default_value("16"))
+        ("r,runs", "Number of runs per hashmap", cxxopts::value<uint32_t>()->default_value("10"))
+        ("b,datasetb", "Path to the used dataset B, its foreign keys are the default group keys", cxxopts::value<std::string>()->default_value("../data/hash_join_larger.txt"))
+        ("j,json", "Path to JSON output", cxxopts::value<std::string>()->implicit_value("json_out.json"))
+        ("i,implementation", "Map implementation(s) to use (" + AggregateBenchmark::Implementations::list() + ")", cxxopts::value<std::vector<std::string>>()->implicit_value("std-blocking"))
+        ("s,seed", "Random seed to use", cxxopts::value<uint64_t>()->default_value("37"))
+        ("strategy", "Aggregation strategy (shared, local, partitioned), a comma separated list sweeps them", cxxopts::value<std::vector<std::string>>()->default_value("shared,local,partitioned"))
+        ("groups", "Group by a key drawn over N groups instead of the foreign keys, a comma separated list sweeps them", cxxopts::value<std::vector<uint64_t>>())
+        ("zipf", "Zipfian skew (theta) of the drawn group keys, 0 for uniform", cxxopts::value<double>()->default_value("0"))
+        ("rows", "Number of rows, dataset B is repeated to fill them (0 for its size)", cxxopts::value<uint64_t>()->default_value("0"))
+        ("h,help", "Print usage");
+
+    add_common_options(options);
+    options.allow_unrecognised_options();
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    auto run_settings = configure_common_options(result);
+
+    auto thread_counts = result["threads"].as<std::vector<uint32_t>>();
+    auto dataset_b_path = result["datasetb"].as<std::string>();
+
+    AggregateBenchmark::RowOptions row_options{};
+    row_options.seed = result["seed"].as<uint64_t>();
+    row_options.num_rows = result["rows"].as<uint64_t>();
+    row_options.zipf = result["zipf"].as<double>();
+
+    std::vector<uint64_t> group_counts = { 0 };
+    if (result.count("groups") > 0) {
+        group_counts = result["groups"].as<std::vector<uint64_t>>();
+    }
+
+    if (row_options.zipf < 0.0 || row_options.zipf >= 1.0) {
+        std::cerr << "Zipfian theta has to be in [0, 1), 0 for uniform" << std::endl;
+        std::exit(-1);
+    }
+
+    // Rows grouped by the foreign keys (no --groups, or 0 in the list) have no drawn keys to skew
+    if (row_options.zipf > 0.0 && std::find(group_counts.begin(), group_counts.end(), 0) != group_counts.end()) {
+        std::cerr << "Skewed keys are drawn over --groups, set it to non-zero counts along with --zipf" << std::endl;
+        std::exit(-1);
+    }
+
+    std::vector<AggregateBenchmark::Strategy> strategies;
+    for (auto& name : result["strategy"].as<std::vector<std::string>>()) {
+        auto strategy = AggregateBenchmark::parse_strategy(name);
+
+        if (!strategy) {
+            std::cerr << "Unknown strategy " << name << std::endl;
+            std::exit(-1);
+        }
+
+        strategies.push_back(*strategy);
+    }
+
+    auto dataset_b = thread_placement().load([&]() { return HashJoinBenchmark::load_dataset_b(dataset_b_path); });
+    auto impls = AggregateBenchmark::Implementations::resolve(result["implementation"].as<std::vector<std::string>>());
+
+    std::cout << "Num threads: " << join(thread_counts) << std::endl;
+    std::cout << "Num runs: " << run_settings.num_runs << " (" << run_settings.num_warmup << " warmup)" << std::endl;
+    std::cout << "Num larger: " << dataset_b.size() << std::endl;
+
+    std::vector<BenchmarkResult> results;
+
+    for (auto num_groups : group_counts) {
+        row_options.num_groups = num_groups;
+
+        auto rows = thread_placement().load([&]() { return AggregateBenchmark::generate_rows(dataset_b, row_options); });
+
+        AggregateBenchmark::BenchmarkOptions benchmark_options{};
+        benchmark_options.expected_hash = AggregateBenchmark::expected_hash(rows);
+
+        std::cout << "Rows: " << rows.size() << ", grouped by " << (num_groups > 0 ? std::to_string(num_groups) + " drawn keys" : "foreign key");
+        std::cout << (num_groups > 0 && row_options.zipf > 0.0 ? " (theta " + std::to_string(row_options.zipf) + ")" : "") << std::endl;
+
+        for (auto strategy : strategies) {
+            benchmark_options.strategy = strategy;
+
+            // Results of a sweep over strategies and groups only differ in their variant
+            auto variant = AggregateBenchmark::strategy_name(strategy);
+            if (num_groups > 0) {
+                std::ostringstream ss;
+                ss << variant << ", " << num_groups << " groups";
+
+                if (row_options.zipf > 0.0) {
+                    ss << ", zipf " << row_options.zipf;
+                }
+
+                variant = ss.str();
+            }
+
+            std::cout << "Strategy: " << variant << std::endl;
+
+            auto strategy_results = run_matrix<AggregateBenchmark::Implementations>(impls, thread_counts, [&](auto entry, uint32_t num_threads) {
+                using Entry = decltype(entry);
+                return AggregateBenchmark::run_benchmark<typename Entry::Map>(Entry::name, rows, benchmark_options, run_settings, num_threads);
+            });
+
+            for (auto& strategy_result : strategy_results) {
+                strategy_result.variant = variant;
+                results.push_back(std::move(strategy_result));
+            }
+        }
+    }
+
+    return results;
 }
 
 auto main(int argc, const char** argv) -> int {
@@ -214,17 +763,25 @@ auto main(int argc, const char** argv) -> int {
         return 0;
     }
 
-    BenchmarkResult benchmark_result;
+    std::vector<BenchmarkResult> benchmark_results;
 
     if (result.count("benchmark") > 0) {
         auto benchmark = result["benchmark"].as<std::string>();
 
         if (benchmark == "wordcount") {
-            benchmark_result = main_wordcount(argc, argv);
+            benchmark_results = main_wordcount(argc, argv);
         } else if (benchmark == "hashjoin") {
-            benchmark_result = main_hashjoin(argc, argv);
+            benchmark_results = main_hashjoin(argc, argv);
         } else if (benchmark == "cache") {
-            benchmark_result = main_cache(argc, argv);
+            benchmark_results = main_cache(argc, argv);
+        } else if (benchmark == "ycsb") {
+            benchmark_results = main_ycsb(argc, argv);
+        } else if (benchmark == "grow") {
+            benchmark_results = main_grow(argc, argv);
+        } else if (benchmark == "churn") {
+            benchmark_results = main_churn(argc, argv);
+        } else if (benchmark == "aggregate") {
+            benchmark_results = main_aggregate(argc, argv);
         } else {
             std::cout << "Unknown benchmark " << benchmark << std::endl;
             std::cout << options.help() << std::endl;
@@ -236,20 +793,25 @@ auto main(int argc, const char** argv) -> int {
         return -1;
     }
 
-    std::cout << "Benchmark result:" << std::endl;
-    std::cout << "Impl:      " << benchmark_result.impl << std::endl;
-    std::cout << "Correct:   " << benchmark_result.correct << std::endl;
-    std::cout << "Hash:      " << benchmark_result.hash << std::endl;
-    std::cout << "Runtime:   " << benchmark_result.total_value << std::endl;
-    std::cout << "Min value:  " << benchmark_result.min_value << std::endl;
-    std::cout << "Max value:  " << benchmark_result.max_value << std::endl;
-    std::cout << "Avg value:  " << benchmark_result.avg_value << std::endl;
-    std::cout << "Mean value: " << benchmark_result.mean_value << std::endl;
+    for (auto& benchmark_result : benchmark_results) {
+        std::cout << "Benchmark result:" << std::endl;
+        std::cout << "Impl:      " << benchmark_result.impl << std::endl;
+        std::cout << "Threads:   " << benchmark_result.num_threads << std::endl;
+        std::cout << "Correct:   " << benchmark_result.correct << std::endl;
+        std::cout << "Hash:      " << benchmark_result.hash << std::endl;
+        std::cout << "Runtime:   " << benchmark_result.total_value << std::endl;
+        std::cout << "Min value:  " << benchmark_result.min_value << std::endl;
+        std::cout << "Max value:  " << benchmark_result.max_value << std::endl;
+        std::cout << "Avg value:  " << benchmark_result.avg_value << std::endl;
+        std::cout << "Median:     " << benchmark_result.mean_value << " (95% CI " << static_cast<uint64_t>(benchmark_result.stats.ci_low) << " - " << static_cast<uint64_t>(benchmark_result.stats.ci_high) << ")" << std::endl;
+        std::cout << "Stddev:     " << static_cast<uint64_t>(benchmark_result.stats.stddev) << std::endl;
+        std::cout << "Runs:       " << benchmark_result.num_runs << " (" << benchmark_result.stats.num_outliers << " outliers)" << std::endl;
+    }
 
     std::cout << "json?: " << result.count("json") << std::endl;
 
     if (result.count("json")) {
-        write_file(result["json"].as<std::string>(), JSONSerializer::serialize_benchmark_result(benchmark_result));
+        write_file(result["json"].as<std::string>(), JSONSerializer::serialize_benchmark_results(benchmark_results));
     }
     
     return 0;
@@ -0,0 +1,380 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <map>
+#include <tuple>
+#include <cctype>
+#include <functional>
+
+#include "../benchmarks/benchmark.hpp"
+#include "huge_pages.hpp"
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Thread pinning and NUMA aware dataset placement. Topology is read from sysfs,
+// on other platforms (or without permissions) threads simply stay unpinned.
+
+enum class AffinityPolicy {
+    None,           // Leave placement to the OS scheduler
+    Compact,        // Fill node by node, hyper-threads of a core next to each other
+    Scatter,        // Round robin over nodes, physical cores before their hyper-threads
+    NumaNode        // Only the cpus of a single node, physical cores first
+};
+
+enum class DataPlacement {
+    FirstTouch,     // Datasets are loaded by a thread pinned like the first worker, landing on it's node
+    Interleave      // Dataset pages are interleaved over all nodes
+};
+
+struct Affinity {
+    AffinityPolicy policy = AffinityPolicy::None;
+    uint32_t node = 0;
+};
+
+inline auto parse_affinity(const std::string& name) -> std::optional<Affinity> {
+    if (name == "none") {
+        return Affinity{ AffinityPolicy::None };
+    } else if (name == "compact") {
+        return Affinity{ AffinityPolicy::Compact };
+    } else if (name == "scatter") {
+        return Affinity{ AffinityPolicy::Scatter };
+    } else if (name.rfind("numa-node:", 0) == 0) {
+        try {
+            return Affinity{ AffinityPolicy::NumaNode, static_cast<uint32_t>(std::stoul(name.substr(10))) };
+        } catch (...) {
+            return {};
+        }
+    }
+
+    return {};
+}
+
+inline auto affinity_name(const Affinity& affinity) -> std::string {
+    switch (affinity.policy) {
+        case AffinityPolicy::Compact:
+            return "compact";
+        case AffinityPolicy::Scatter:
+            return "scatter";
+        case AffinityPolicy::NumaNode:
+            return "numa-node:" + std::to_string(affinity.node);
+        default:
+            return "none";
+    }
+}
+
+inline auto parse_data_placement(const std::string& name) -> std::optional<DataPlacement> {
+    if (name == "first-touch") {
+        return DataPlacement::FirstTouch;
+    } else if (name == "interleave") {
+        return DataPlacement::Interleave;
+    }
+
+    return {};
+}
+
+inline auto data_placement_name(DataPlacement placement) -> std::string {
+    return placement == DataPlacement::Interleave ? "interleave" : "first-touch";
+}
+
+struct CpuInfo {
+    uint32_t cpu;
+    uint32_t node;
+    uint32_t package;
+    uint32_t core;
+    uint32_t sibling;       // Index among the hyper-threads of the same core
+};
+
+// Parses cpu (and node) lists like "0-3,8,10-11"
+inline auto parse_cpu_list(const std::string& text) -> std::vector<uint32_t> {
+    std::vector<uint32_t> result;
+    std::stringstream ss(text);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0]))) {
+            continue;
+        }
+
+        auto dash = range.find('-');
+        auto first = std::stoul(range.substr(0, dash));
+        auto last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+
+        for (auto cpu = first; cpu <= last; cpu++) {
+            result.push_back(static_cast<uint32_t>(cpu));
+        }
+    }
+
+    return result;
+}
+
+inline auto read_sysfs(const std::string& path) -> std::optional<std::string> {
+    std::ifstream file(path);
+    std::string line;
+
+    if (!file.is_open() || !std::getline(file, line)) {
+        return {};
+    }
+
+    return line;
+}
+
+// CPUs the process may run on, with their node and core
+inline auto detect_topology() -> std::vector<CpuInfo> {
+    std::vector<CpuInfo> cpus;
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    auto has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    auto online = read_sysfs("/sys/devices/system/cpu/online");
+    auto online_nodes = read_sysfs("/sys/devices/system/node/online");
+    std::map<uint32_t, uint32_t> nodes;
+
+    for (auto node : parse_cpu_list(online_nodes.value_or(""))) {
+        auto list = read_sysfs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+
+        for (auto cpu : parse_cpu_list(list.value_or(""))) {
+            nodes[cpu] = node;
+        }
+    }
+
+    if (online) {
+        for (auto cpu : parse_cpu_list(*online)) {
+            if (has_mask && !CPU_ISSET(cpu, &allowed)) {
+                continue;
+            }
+
+            auto base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            auto package = read_sysfs(base + "physical_package_id");
+            auto core = read_sysfs(base + "core_id");
+
+            cpus.push_back(CpuInfo{
+                cpu,
+                nodes.count(cpu) ? nodes[cpu] : 0,
+                package ? static_cast<uint32_t>(std::stoul(*package)) : 0,
+                core ? static_cast<uint32_t>(std::stoul(*core)) : cpu,
+                0
+            });
+        }
+    }
+#endif
+
+    // Unknown topology, assume a single node without hyper-threading
+    if (cpus.empty()) {
+        for (uint32_t cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+            cpus.push_back(CpuInfo{ cpu, 0, 0, cpu, 0 });
+        }
+    }
+
+    std::map<std::tuple<uint32_t, uint32_t>, uint32_t> siblings;
+    for (auto& info : cpus) {
+        info.sibling = siblings[{ info.package, info.core }]++;
+    }
+
+    return cpus;
+}
+
+// Maps thread slots to cpus following the affinity policy. Slots are assigned in order,
+// workers take the first ones, helper threads (e.g. cache cleaners) the following ones.
+class ThreadPlacement {
+    public:
+        auto configure(Affinity affinity, DataPlacement placement) -> bool {
+            this->affinity = affinity;
+            this->placement = placement;
+            this->cpus.clear();
+
+            auto topology = detect_topology();
+
+            auto by_core = [](const CpuInfo& a, const CpuInfo& b) {
+                return std::tie(a.sibling, a.package, a.core, a.cpu) < std::tie(b.sibling, b.package, b.core, b.cpu);
+            };
+
+            switch (affinity.policy) {
+                case AffinityPolicy::None:
+                    return true;
+                case AffinityPolicy::Compact:
+                    std::sort(topology.begin(), topology.end(), [](const CpuInfo& a, const CpuInfo& b) {
+                        return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+                    });
+
+                    this->cpus = topology;
+                    break;
+                case AffinityPolicy::Scatter: {
+                    std::map<uint32_t, std::vector<CpuInfo>> nodes;
+                    for (auto& info : topology) {
+                        nodes[info.node].push_back(info);
+                    }
+
+                    for (auto& [node, list] : nodes) {
+                        std::sort(list.begin(), list.end(), by_core);
+                    }
+
+                    for (size_t i = 0; this->cpus.size() < topology.size(); i++) {
+                        for (auto& [node, list] : nodes) {
+                            if (i < list.size()) {
+                                this->cpus.push_back(list[i]);
+                            }
+                        }
+                    }
+                    break;
+                }
+                case AffinityPolicy::NumaNode:
+                    for (auto& info : topology) {
+                        if (info.node == affinity.node) {
+                            this->cpus.push_back(info);
+                        }
+                    }
+
+                    std::sort(this->cpus.begin(), this->cpus.end(), by_core);
+                    break;
+            }
+
+            return !this->cpus.empty();
+        }
+
+        // Cpu of a thread slot, slots beyond the number of cpus wrap around
+        auto cpu_of(uint32_t slot) const -> std::optional<CpuInfo> {
+            if (this->cpus.empty()) {
+                return {};
+            }
+
+            return this->cpus[slot % this->cpus.size()];
+        }
+
+        // Pins the calling thread to the slot's cpu, no-op without a policy
+        auto pin(uint32_t slot) const -> bool {
+            auto info = this->cpu_of(slot);
+            if (!info) {
+                return false;
+            }
+
+            return pin_to({ info->cpu });
+        }
+
+        // Loads a dataset following the data placement, the calling thread's affinity and memory policy are restored afterwards
+        template<typename F>
+        auto load(F&& load_dataset) const -> decltype(load_dataset()) {
+#ifdef __linux__
+            cpu_set_t previous;
+            CPU_ZERO(&previous);
+            auto restore = sched_getaffinity(0, sizeof(previous), &previous) == 0;
+
+            if (this->placement == DataPlacement::Interleave) {
+                set_interleave(true);
+            } else {
+                this->pin(0);
+            }
+
+            auto before = HugePages::mode().load() != HugePageMode::Off ? HugePages::anonymous_ranges() : HugePages::Ranges{};
+            auto result = load_dataset();
+
+            if (this->placement == DataPlacement::Interleave) {
+                set_interleave(false);
+            }
+
+            HugePages::back_new_ranges(before);
+
+            if (restore) {
+                sched_setaffinity(0, sizeof(previous), &previous);
+            }
+
+            return result;
+#else
+            return load_dataset();
+#endif
+        }
+
+        // Cpus and nodes of the first num_threads slots, empty without pinning
+        auto get_layout(uint32_t num_threads) const -> ThreadLayout {
+            ThreadLayout layout{ affinity_name(this->affinity), data_placement_name(this->placement) };
+
+            for (uint32_t slot = 0; slot < num_threads && !this->cpus.empty(); slot++) {
+                auto info = *this->cpu_of(slot);
+                layout.cpus.push_back(info.cpu);
+                layout.nodes.push_back(info.node);
+            }
+
+            return layout;
+        }
+
+        auto get_affinity() const -> Affinity {
+            return this->affinity;
+        }
+
+        auto get_placement() const -> DataPlacement {
+            return this->placement;
+        }
+
+        auto get_num_cpus() const -> uint32_t {
+            return static_cast<uint32_t>(this->cpus.size());
+        }
+
+    private:
+        static auto pin_to(const std::vector<uint32_t>& cpu_list) -> bool {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+
+            for (auto cpu : cpu_list) {
+                CPU_SET(cpu, &set);
+            }
+
+            return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+            return false;
+#endif
+        }
+
+        // Interleaves new pages of the calling thread over all nodes, libnuma isn't required for the raw syscall
+        static auto set_interleave(bool enable) -> bool {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+            constexpr int MPOL_DEFAULT_MODE = 0;
+            constexpr int MPOL_INTERLEAVE_MODE = 3;
+
+            if (!enable) {
+                return syscall(SYS_set_mempolicy, MPOL_DEFAULT_MODE, nullptr, 0) == 0;
+            }
+
+            unsigned long mask[16] = {};
+            for (auto& info : detect_topology()) {
+                if (info.node < sizeof(mask) * 8) {
+                    mask[info.node / (sizeof(unsigned long) * 8)] |= 1ul << (info.node % (sizeof(unsigned long) * 8));
+                }
+            }
+
+            return syscall(SYS_set_mempolicy, MPOL_INTERLEAVE_MODE, mask, sizeof(mask) * 8) == 0;
+#else
+            return false;
+#endif
+        }
+
+        Affinity affinity{};
+        DataPlacement placement = DataPlacement::FirstTouch;
+        std::vector<CpuInfo> cpus;
+};
+
+inline auto thread_placement() -> ThreadPlacement& {
+    // Configured once by main, before any benchmark threads are started
+    static ThreadPlacement placement;
+    return placement;
+}
+
+// Same as std::thread(f, args...), but pins the new thread to the cpu of the given slot first
+template<typename F, typename... Args>
+inline auto pinned_thread(uint32_t slot, F&& f, Args&&... args) -> std::thread {
+    return std::thread([slot, task = std::bind(std::forward<F>(f), std::forward<Args>(args)...)]() mutable {
+        thread_placement().pin(slot);
+        task();
+    });
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <climits>
+#include <optional>
+#include "timer.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+// How threads wait at a barrier
+enum class BarrierWait {
+    Spin,       // Busy wait (yielding once the spin budget is used up), releases all threads within a few hundred ns
+    Futex       // Spin briefly, then sleep in the kernel, for oversubscribed machines
+};
+
+inline auto parse_barrier_wait(const std::string& name) -> std::optional<BarrierWait> {
+    if (name == "spin") {
+        return BarrierWait::Spin;
+    } else if (name == "futex") {
+        return BarrierWait::Futex;
+    }
+
+    return {};
+}
+
+inline auto barrier_wait_name(BarrierWait wait) -> std::string {
+    return wait == BarrierWait::Futex ? "futex" : "spin";
+}
+
+inline auto cpu_relax() -> void {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+    _mm_pause();
+#endif
+}
+
+// Sense-reversing barrier, reusable for any number of phases. Every participant (including the
+// main thread starting the timer) calls arrive_and_wait(), the last one to arrive flips the sense,
+// releasing all others at once instead of waking them one by one like a condition variable.
+class SpinBarrier {
+    public:
+        // Selected by --barrier, used by all barriers created afterwards
+        static auto default_wait() -> std::atomic<BarrierWait>& {
+            static std::atomic<BarrierWait> value = BarrierWait::Spin;
+            return value;
+        }
+
+        SpinBarrier(uint32_t num_participants) : SpinBarrier(num_participants, default_wait().load()) {
+        }
+
+        SpinBarrier(uint32_t num_participants, BarrierWait wait) : num_participants(num_participants), wait(wait), remaining(num_participants) {
+        }
+
+        SpinBarrier(const SpinBarrier&) = delete;
+        auto operator=(const SpinBarrier&) -> SpinBarrier& = delete;
+
+        auto arrive_and_wait() -> void {
+            // The sense can't flip again before we arrived, so the current value tells us which phase we're in
+            auto local_sense = this->sense.load(std::memory_order_relaxed) ^ 1;
+
+            if (this->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->release_timepoint = get_timepoint();
+                this->remaining.store(this->num_participants, std::memory_order_relaxed);
+                // Sequentially consistent, a sleeper announcing itself afterwards has to see the new sense
+                this->sense.store(local_sense, std::memory_order_seq_cst);
+                this->wake_all();
+                return;
+            }
+
+            for (uint32_t spins = 0; this->sense.load(std::memory_order_acquire) != local_sense; spins++) {
+                if (spins < SPIN_LIMIT) {
+                    cpu_relax();
+                } else if (this->wait == BarrierWait::Futex) {
+                    this->sleep(local_sense ^ 1);
+                } else {
+                    // More threads than cpus, let the threads we're waiting for run
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // Taken by the last thread to arrive, right before everyone was released
+        auto get_release_timepoint() const -> uint64_t {
+            return this->release_timepoint;
+        }
+
+    private:
+        static constexpr uint32_t SPIN_LIMIT = 1u << 14;
+
+        auto sleep(uint32_t old_sense) -> void {
+#ifdef __linux__
+            this->sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+            // Returns right away if the sense already flipped
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->sense), FUTEX_WAIT_PRIVATE, old_sense, nullptr, nullptr, 0);
+
+            this->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        auto wake_all() -> void {
+#ifdef __linux__
+            if (this->wait == BarrierWait::Futex && this->sleepers.load(std::memory_order_seq_cst) > 0) {
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->sense), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+            }
+#endif
+        }
+
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+
+        const uint32_t num_participants;
+        const BarrierWait wait;
+
+        // Arrivals and the released flag on separate cache lines, waiting threads only ever read the sense
+        alignas(64) std::atomic<uint32_t> remaining;
+        alignas(64) std::atomic<uint32_t> sense = 0;
+        std::atomic<uint32_t> sleepers = 0;
+        uint64_t release_timepoint = 0;
+};
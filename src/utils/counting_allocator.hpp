@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include "map_heap.hpp"
+
+// Bytes currently (and at most) held by all maps using the CountingAllocator.
+// Only a single map is alive at a time, so one process wide counter is enough.
+class AllocationCounter {
+    public:
+        static auto get() -> AllocationCounter& {
+            static AllocationCounter counter;
+            return counter;
+        }
+
+        // Toggled by --memory, allocations aren't counted otherwise
+        static auto enabled() -> std::atomic<bool>& {
+            static std::atomic<bool> value = false;
+            return value;
+        }
+
+        auto add(uint64_t bytes) -> void {
+            auto current = this->current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            auto peak = this->peak.load(std::memory_order_relaxed);
+
+            while (current > peak && !this->peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+            }
+        }
+
+        auto sub(uint64_t bytes) -> void {
+            this->current.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        // Starts a new peak from the current value
+        auto reset_peak() -> void {
+            this->peak.store(this->current.load());
+        }
+
+        auto get_current() const -> uint64_t {
+            return this->current.load();
+        }
+
+        auto get_peak() const -> uint64_t {
+            return this->peak.load();
+        }
+
+    private:
+        alignas(64) std::atomic<uint64_t> current = 0;
+        alignas(64) std::atomic<uint64_t> peak = 0;
+};
+
+// Stateless allocator on top of the MapHeap (std, pool or arena), passed as the allocator template parameter of maps supporting one
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() noexcept = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept {
+    }
+
+    auto allocate(size_t n) -> T* {
+        auto ptr = static_cast<T*>(MapHeap::allocate(n * sizeof(T), alignof(T)));
+
+        if (AllocationCounter::enabled().load(std::memory_order_relaxed)) {
+            AllocationCounter::get().add(n * sizeof(T));
+        }
+
+        return ptr;
+    }
+
+    auto deallocate(T* ptr, size_t n) -> void {
+        if (AllocationCounter::enabled().load(std::memory_order_relaxed)) {
+            AllocationCounter::get().sub(n * sizeof(T));
+        }
+
+        MapHeap::deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    auto operator==(const CountingAllocator<U>&) const -> bool {
+        return true;
+    }
+
+    template<typename U>
+    auto operator!=(const CountingAllocator<U>&) const -> bool {
+        return false;
+    }
+};
+
+// Allocator for the nodes / slots of a map from K to V
+template<typename K, typename V>
+using MapAllocator = CountingAllocator<std::pair<const K, V>>;
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+#include <utility>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#endif
+
+// Page size behind large map allocations (bucket arrays, pool / arena chunks, cache slabs) and loaded datasets, selected with --hugepages
+enum class HugePageMode {
+    Off,        // Whatever the system does by default
+    THP,        // Transparent huge pages, requested with madvise(MADV_HUGEPAGE)
+    Explicit    // Reserved huge pages (vm.nr_hugepages) through MAP_HUGETLB, THP where none are left
+};
+
+inline auto parse_huge_page_mode(const std::string& name) -> std::optional<HugePageMode> {
+    if (name == "off") {
+        return HugePageMode::Off;
+    } else if (name == "thp") {
+        return HugePageMode::THP;
+    } else if (name == "explicit") {
+        return HugePageMode::Explicit;
+    }
+
+    return {};
+}
+
+inline auto huge_page_mode_name(HugePageMode mode) -> std::string {
+    switch (mode) {
+        case HugePageMode::THP: return "thp";
+        case HugePageMode::Explicit: return "explicit";
+        default: return "off";
+    }
+}
+
+// Blocks of at least a huge page come straight from mmap, aligned to a huge page. Whatever can't be backed (no reserved
+// pages left, THP disabled) falls back to the next option and finally to regular pages, with a warning printed once.
+class HugePages {
+    public:
+        static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+        using Ranges = std::vector<std::pair<uintptr_t, uintptr_t>>;
+
+        // Set once from --hugepages, before the first map is created or dataset loaded
+        static auto mode() -> std::atomic<HugePageMode>& {
+            static std::atomic<HugePageMode> value = HugePageMode::Off;
+            return value;
+        }
+
+        // Whether a block of this size is allocated here, allocate() and deallocate() must only be used if so
+        static auto backs(size_t bytes) -> bool {
+#ifdef __linux__
+            return bytes >= HUGE_PAGE_SIZE && mode().load(std::memory_order_relaxed) != HugePageMode::Off;
+#else
+            return false;
+#endif
+        }
+
+        static auto allocate(size_t bytes) -> void* {
+#ifdef __linux__
+            auto size = round_up(bytes);
+
+            if (mode().load(std::memory_order_relaxed) == HugePageMode::Explicit) {
+                auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+                if (ptr != MAP_FAILED) {
+                    return ptr;
+                }
+
+                warn_once(explicit_warned(), "No reserved huge pages left (vm.nr_hugepages), falling back to transparent huge pages");
+            }
+
+            // Over-allocate by a page and cut off both ends, so the block starts at a huge page boundary
+            auto raw = static_cast<char*>(mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+
+            auto aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw)));
+            if (aligned > raw) {
+                munmap(raw, aligned - raw);
+            }
+
+            munmap(aligned + size, raw + HUGE_PAGE_SIZE - aligned);
+
+            if (madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+                warn_once(thp_warned(), "Transparent huge pages are not available, using regular pages");
+            }
+
+            return aligned;
+#else
+            return ::operator new(bytes);
+#endif
+        }
+
+        static auto deallocate(void* ptr, size_t bytes) -> void {
+#ifdef __linux__
+            munmap(ptr, round_up(bytes));
+#else
+            ::operator delete(ptr);
+#endif
+        }
+
+        // Private anonymous mappings (the heap and malloc's mmaps), sorted by address
+        static auto anonymous_ranges() -> Ranges {
+            Ranges ranges;
+            std::ifstream maps("/proc/self/maps");
+            std::string line;
+
+            while (std::getline(maps, line)) {
+                std::istringstream fields(line);
+                std::string range, perms, offset, device, path;
+                uint64_t inode = 0;
+
+                fields >> range >> perms >> offset >> device >> inode >> path;
+
+                if (perms.size() < 4 || perms[0] != 'r' || perms[1] != 'w' || perms[3] != 'p' || inode != 0 || (!path.empty() && path != "[heap]")) {
+                    continue;
+                }
+
+                auto dash = range.find('-');
+                ranges.emplace_back(std::stoull(range.substr(0, dash), nullptr, 16), std::stoull(range.substr(dash + 1), nullptr, 16));
+            }
+
+            return ranges;
+        }
+
+        // Backs whatever was mapped since the before snapshot (a loaded dataset) with transparent huge pages. The memory is
+        // already faulted in on regular pages, MADV_COLLAPSE (Linux 6.1) rebuilds it in place, older kernels leave it to khugepaged.
+        // Reserved huge pages can't replace memory in place, so explicit mode does the same.
+        static auto back_new_ranges(const Ranges& before) -> void {
+#ifdef __linux__
+            if (mode().load() == HugePageMode::Off) {
+                return;
+            }
+
+            uint64_t advised = 0, collapsed = 0;
+
+            for (auto [start, end] : anonymous_ranges()) {
+                // Cut out what was there before, the heap only grew at its end but mmaps may have merged with older ones
+                for (auto& [old_start, old_end] : before) {
+                    if (old_end <= start || old_start >= end) {
+                        continue;
+                    }
+
+                    if (old_start <= start) {
+                        start = std::min(end, old_end);
+                    } else {
+                        madvise_range(start, old_start, advised, collapsed);
+                        start = std::min(end, old_end);
+                    }
+                }
+
+                madvise_range(start, end, advised, collapsed);
+            }
+
+            std::cout << "Huge pages: " << (advised >> 20) << "MiB of the dataset advised, " << (collapsed >> 20) << "MiB collapsed" << std::endl;
+#endif
+        }
+
+        // Bytes of the process in transparent or reserved huge pages
+        static auto get_backed_bytes() -> uint64_t {
+            std::ifstream rollup("/proc/self/smaps_rollup");
+            std::string line;
+            uint64_t total = 0;
+
+            while (std::getline(rollup, line)) {
+                if (line.rfind("AnonHugePages:", 0) == 0 || line.rfind("Private_Hugetlb:", 0) == 0 || line.rfind("Shared_Hugetlb:", 0) == 0) {
+                    total += std::stoull(line.substr(line.find(':') + 1)) * 1024;
+                }
+            }
+
+            return total;
+        }
+
+        // What the system offers, for the startup banner
+        static auto describe() -> std::string {
+            std::ifstream enabled("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::string thp = "unavailable";
+            std::getline(enabled, thp);
+
+            auto open = thp.find('[');
+            auto close = thp.find(']');
+            if (open != std::string::npos && close != std::string::npos) {
+                thp = thp.substr(open + 1, close - open - 1);
+            }
+
+            std::ifstream meminfo("/proc/meminfo");
+            std::string line, reserved = "0";
+
+            while (std::getline(meminfo, line)) {
+                if (line.rfind("HugePages_Free:", 0) == 0) {
+                    reserved = line.substr(line.find_first_not_of(' ', line.find(':') + 1));
+                }
+            }
+
+            return "THP " + thp + ", " + reserved + " reserved pages free";
+        }
+
+    private:
+        static auto round_up(uintptr_t bytes) -> uintptr_t {
+            return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        }
+
+        static auto madvise_range(uintptr_t start, uintptr_t end, uint64_t& advised, uint64_t& collapsed) -> void {
+#ifdef __linux__
+            // Only whole huge pages inside the range
+            start = round_up(start);
+            end = end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+            if (start >= end) {
+                return;
+            }
+
+            auto ptr = reinterpret_cast<void*>(start);
+            if (madvise(ptr, end - start, MADV_HUGEPAGE) != 0) {
+                warn_once(thp_warned(), "Transparent huge pages are not available, using regular pages");
+                return;
+            }
+
+            advised += end - start;
+
+#ifndef MADV_COLLAPSE
+            constexpr int MADV_COLLAPSE = 25;
+#endif
+            if (madvise(ptr, end - start, MADV_COLLAPSE) == 0) {
+                collapsed += end - start;
+            }
+#endif
+        }
+
+        static auto explicit_warned() -> std::atomic<bool>& {
+            static std::atomic<bool> value = false;
+            return value;
+        }
+
+        static auto thp_warned() -> std::atomic<bool>& {
+            static std::atomic<bool> value = false;
+            return value;
+        }
+
+        static auto warn_once(std::atomic<bool>& warned, const char* message) -> void {
+            if (!warned.exchange(true)) {
+                std::cerr << message << std::endl;
+            }
+        }
+};
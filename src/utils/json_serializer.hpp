@@ -1,11 +1,123 @@
 #pragma once
 #include <string>
 #include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <map>
+#include <vector>
 
 #include "../benchmarks/benchmark.hpp"
 
 class JSONSerializer {
     public:
+        static auto serialize_metrics(const std::map<std::string, double>& metrics) -> std::string {
+            std::stringstream ss;
+
+            ss << std::setprecision(15) << "{";
+
+            bool first = true;
+            for (auto& [name, value] : metrics) {
+                if (!first) {
+                    ss << ", ";
+                }
+
+                // JSON has no representation for NaN/Inf
+                if (std::isfinite(value)) {
+                    ss << "\"" << name << "\": " << value;
+                } else {
+                    ss << "\"" << name << "\": null";
+                }
+
+                first = false;
+            }
+
+            ss << "}";
+            return ss.str();
+        }
+
+        template<typename T>
+        static auto serialize_list(const std::vector<T>& values) -> std::string {
+            std::stringstream ss;
+
+            ss << "[";
+
+            for (int i = 0; i < values.size(); i++) {
+                ss << (i ? ", " : "") << values[i];
+            }
+
+            ss << "]";
+            return ss.str();
+        }
+
+        static auto serialize_layout(const ThreadLayout& layout) -> std::string {
+            std::stringstream ss;
+
+            ss << "{";
+            ss << "\"affinity\": \"" << layout.affinity << "\", ";
+            ss << "\"placement\": \"" << layout.placement << "\", ";
+            ss << "\"cpus\": " << JSONSerializer::serialize_list(layout.cpus) << ", ";
+            ss << "\"nodes\": " << JSONSerializer::serialize_list(layout.nodes);
+            ss << "}";
+
+            return ss.str();
+        }
+
+        static auto serialize_statistics(const RunStatistics& stats) -> std::string {
+            return JSONSerializer::serialize_metrics({
+                { "median", stats.median },
+                { "mean", stats.mean },
+                { "stddev", stats.stddev },
+                { "confidence", stats.confidence },
+                { "ci_low", stats.ci_low },
+                { "ci_high", stats.ci_high },
+                { "ci_half_width_pct", stats.ci_half_width_pct },
+                { "outlier_low", stats.outlier_low },
+                { "outlier_high", stats.outlier_high },
+                { "num_outliers", static_cast<double>(stats.num_outliers) }
+            });
+        }
+
+        static auto serialize_phases(const std::vector<PhaseResult>& phases) -> std::string {
+            std::stringstream ss;
+
+            ss << "[";
+
+            for (int i = 0; i < phases.size(); i++) {
+                auto& phase = phases[i];
+
+                ss << (i ? ", " : "") << "{";
+                ss << "\"name\": \"" << phase.name << "\", ";
+                ss << "\"duration_ns\": " << phase.duration_ns << ", ";
+                ss << "\"thread_starts\": " << JSONSerializer::serialize_list(phase.thread_starts) << ", ";
+                ss << "\"thread_ends\": " << JSONSerializer::serialize_list(phase.thread_ends);
+                ss << "}";
+            }
+
+            ss << "]";
+            return ss.str();
+        }
+
+        static auto serialize_timeseries(const std::vector<TimeSeries>& timeseries) -> std::string {
+            std::stringstream ss;
+
+            ss << "[";
+
+            for (int i = 0; i < timeseries.size(); i++) {
+                auto& series = timeseries[i];
+
+                ss << (i ? ", " : "") << "{";
+                ss << "\"name\": \"" << series.name << "\", ";
+                ss << "\"interval_ms\": " << series.interval_ms << ", ";
+                ss << "\"unit\": \"" << series.unit << "\", ";
+                ss << "\"time_ns\": " << JSONSerializer::serialize_list(series.time_ns) << ", ";
+                ss << "\"values\": " << JSONSerializer::serialize_list(series.values);
+                ss << "}";
+            }
+
+            ss << "]";
+            return ss.str();
+        }
+
         static auto serialize_run_results(BenchmarkResult& result) -> std::string {
             std::stringstream ss;
 
@@ -20,8 +132,22 @@ class JSONSerializer {
 
                 ss << "        " << "{\n";
                 ss << "            " << "\"value\": " << run.value << ",\n";
-                ss << "            " << "\"hash\": " << run.hash << "\n";
-                ss << "        " << "}";
+                ss << "            " << "\"hash\": " << run.hash << ",\n";
+                ss << "            " << "\"outlier\": " << (run.outlier ? "true" : "false");
+
+                if (!run.phases.empty()) {
+                    ss << ",\n" << "            " << "\"phases\": " << JSONSerializer::serialize_phases(run.phases);
+                }
+
+                if (!run.timeseries.empty()) {
+                    ss << ",\n" << "            " << "\"timeseries\": " << JSONSerializer::serialize_timeseries(run.timeseries);
+                }
+
+                if (!run.metrics.empty()) {
+                    ss << ",\n" << "            " << "\"metrics\": " << JSONSerializer::serialize_metrics(run.metrics);
+                }
+
+                ss << "\n" << "        " << "}";
             }
 
             ss << "\n    ],";
@@ -41,15 +167,64 @@ class JSONSerializer {
             ss << "    " << "\"value_unit\": "      << "\"" << result.value_unit << "\"" << ",\n";
             ss << "    " << "\"correct\": "         << (result.correct ? "true" : "false") << ",\n";
             ss << "    " << "\"num_runs\": "        << result.num_runs << ",\n";
+            ss << "    " << "\"num_warmup\": "      << result.num_warmup << ",\n";
             ss << "    " << "\"num_threads\": "     << result.num_threads << ",\n";
+
+            if (result.value_size > 0) {
+                ss << "    " << "\"key_size\": "    << result.key_size << ",\n";
+                ss << "    " << "\"value_size\": "  << result.value_size << ",\n";
+            }
+
+            if (!result.allocator.empty()) {
+                ss << "    " << "\"allocator\": "   << "\"" << result.allocator << "\"" << ",\n";
+            }
+
+            if (!result.hugepages.empty()) {
+                ss << "    " << "\"hugepages\": "   << "\"" << result.hugepages << "\"" << ",\n";
+            }
+
+            if (!result.variant.empty()) {
+                ss << "    " << "\"variant\": "     << "\"" << result.variant << "\"" << ",\n";
+            }
+
+            if (!result.layout.affinity.empty()) {
+                ss << "    " << "\"layout\": "      << JSONSerializer::serialize_layout(result.layout) << ",\n";
+            }
+
             ss << "    " << "\"total_value\": "     << result.total_value << ",\n";
             ss << "    " << "\"min_value\": "       << result.min_value << ",\n";
             ss << "    " << "\"avg_value\": "       << result.avg_value << ",\n";
             ss << "    " << "\"mean_value\": "      << result.mean_value << ",\n";
-            ss << "    " << "\"max_value\": "       << result.max_value << "\n";
+            ss << "    " << "\"max_value\": "       << result.max_value << ",\n";
+            ss << "    " << "\"statistics\": "      << JSONSerializer::serialize_statistics(result.stats) << "\n";
 
             ss << "}\n";
 
             return ss.str();
         }
+
+        // A single result is written as is, a whole matrix (implementations x thread counts) as an array of results
+        static auto serialize_benchmark_results(std::vector<BenchmarkResult>& results) -> std::string {
+            if (results.size() == 1) {
+                return JSONSerializer::serialize_benchmark_result(results.front());
+            }
+
+            std::stringstream ss;
+
+            ss << "[\n";
+
+            for (int i = 0; i < results.size(); i++) {
+                if (i) {
+                    ss << ",\n";
+                }
+
+                auto text = JSONSerializer::serialize_benchmark_result(results[i]);
+                text.pop_back();
+                ss << text;
+            }
+
+            ss << "\n]\n";
+
+            return ss.str();
+        }
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <algorithm>
+#include "../benchmarks/benchmark.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Log-linear histogram of per operation latencies (ns), 16 sub-buckets per power of two, so every
+// recorded value is off by at most 1/16. Recording is a few instructions, each thread keeps its own and they're merged afterwards.
+class LatencyHistogram {
+    public:
+        auto record(uint64_t ns) -> void {
+            this->counts[bucket_of(ns)]++;
+            this->count++;
+            this->sum += ns;
+            this->max = std::max(this->max, ns);
+        }
+
+        auto merge(const LatencyHistogram& other) -> void {
+            for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+                this->counts[i] += other.counts[i];
+            }
+
+            this->count += other.count;
+            this->sum += other.sum;
+            this->max = std::max(this->max, other.max);
+        }
+
+        // Upper bound of the bucket holding the q-th quantile
+        auto quantile(double q) const -> uint64_t {
+            if (this->count == 0) {
+                return 0;
+            }
+
+            auto rank = static_cast<uint64_t>(q * (this->count - 1)) + 1;
+            uint64_t seen = 0;
+
+            for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+                seen += this->counts[i];
+                if (seen >= rank) {
+                    return std::min(upper_bound_of(i), this->max);
+                }
+            }
+
+            return this->max;
+        }
+
+        auto get_count() const -> uint64_t {
+            return this->count;
+        }
+
+        auto get_max() const -> uint64_t {
+            return this->max;
+        }
+
+        auto get_mean() const -> double {
+            return this->count > 0 ? static_cast<double>(this->sum) / this->count : 0.0;
+        }
+
+        // <name>_p50_ns, _p99_ns, _p999_ns, _max_ns and _avg_ns
+        auto report(RunResult& result, const std::string& name) const -> void {
+            result.metrics[name + "_p50_ns"] = this->quantile(0.5);
+            result.metrics[name + "_p99_ns"] = this->quantile(0.99);
+            result.metrics[name + "_p999_ns"] = this->quantile(0.999);
+            result.metrics[name + "_max_ns"] = this->max;
+            result.metrics[name + "_avg_ns"] = this->get_mean();
+        }
+
+    private:
+        static constexpr uint32_t SUB_BITS = 4;
+        static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BITS;
+        static constexpr uint32_t NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        static auto bucket_of(uint64_t ns) -> uint32_t {
+            if (ns < SUB_BUCKETS) {
+                return static_cast<uint32_t>(ns);
+            }
+
+#ifdef _MSC_VER
+            unsigned long exponent = 0;
+            _BitScanReverse64(&exponent, ns);
+#else
+            uint32_t exponent = 63 - __builtin_clzll(ns);
+#endif
+            uint32_t sub = static_cast<uint32_t>(ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+
+            return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+        }
+
+        static auto upper_bound_of(uint32_t bucket) -> uint64_t {
+            if (bucket < SUB_BUCKETS) {
+                return bucket;
+            }
+
+            uint32_t exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+            uint64_t sub = bucket % SUB_BUCKETS;
+            uint64_t width = 1ull << (exponent - SUB_BITS);
+
+            return ((SUB_BUCKETS + sub) << (exponent - SUB_BITS)) + width - 1;
+        }
+
+        uint64_t counts[NUM_BUCKETS] = {};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+};
@@ -0,0 +1,309 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include <utility>
+#include <optional>
+#include "huge_pages.hpp"
+
+// Where the maps' nodes, buckets and (for Junction) values are allocated, selected with --allocator
+enum class HeapKind {
+    Std,        // The global operator new
+    Pool,       // Thread local free lists per size class, carved out of the run's chunks
+    Arena       // Thread local bump pointers into the run's chunks, frees are no-ops
+};
+
+inline auto parse_heap_kind(const std::string& name) -> std::optional<HeapKind> {
+    if (name == "std") {
+        return HeapKind::Std;
+    } else if (name == "pool") {
+        return HeapKind::Pool;
+    } else if (name == "arena") {
+        return HeapKind::Arena;
+    }
+
+    return {};
+}
+
+inline auto heap_kind_name(HeapKind kind) -> std::string {
+    switch (kind) {
+        case HeapKind::Pool: return "pool";
+        case HeapKind::Arena: return "arena";
+        default: return "std";
+    }
+}
+
+// The chunks pools and arenas hand out memory from. They belong to the current run and are released in bulk
+// once its map is gone (see run_iterations). Every thread keeps its free lists and bump pointer in a thread local
+// cache tagged with the run's generation, a cache left over from an earlier run is dropped on first use.
+class MapHeap {
+    public:
+        static auto get() -> MapHeap& {
+            static MapHeap heap;
+            return heap;
+        }
+
+        // Set once from --allocator, before the first map is created
+        static auto kind() -> std::atomic<HeapKind>& {
+            static std::atomic<HeapKind> value = HeapKind::Std;
+            return value;
+        }
+
+        static auto allocate(size_t bytes, size_t alignment) -> void* {
+            auto kind = MapHeap::kind().load(std::memory_order_relaxed);
+
+            if (kind == HeapKind::Pool && pooled(bytes, alignment)) {
+                auto& cache = local();
+                auto size_class = class_of(bytes);
+
+                if (cache.free_lists[size_class] == nullptr) {
+                    get().take_batch(cache, size_class);
+                }
+
+                if (auto block = cache.free_lists[size_class]) {
+                    cache.free_lists[size_class] = block->next;
+                    cache.free_counts[size_class]--;
+                    return block;
+                }
+
+                return bump(cache, MIN_CLASS << size_class, MIN_CLASS);
+            } else if (kind == HeapKind::Arena && alignment <= CHUNK_ALIGNMENT) {
+                // Large blocks (bucket arrays) get a chunk of their own, they'd waste most of a shared one
+                if (bytes > chunk_size() / 4) {
+                    return get().chunk(bytes);
+                }
+
+                return bump(local(), bytes, alignment);
+            }
+
+            if (HugePages::backs(bytes)) {
+                return HugePages::allocate(bytes);
+            }
+
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return ::operator new(bytes, std::align_val_t(alignment));
+            }
+
+            return ::operator new(bytes);
+        }
+
+        static auto deallocate(void* ptr, size_t bytes, size_t alignment) -> void {
+            auto kind = MapHeap::kind().load(std::memory_order_relaxed);
+
+            if (kind == HeapKind::Pool && pooled(bytes, alignment)) {
+                // Goes to the freeing thread's list, whichever thread allocated it. Threads freeing more than they
+                // allocate (the cache's cleaners) pass batches on to the depot, where the allocating threads find them
+                auto& cache = local();
+                auto size_class = class_of(bytes);
+                auto block = static_cast<FreeBlock*>(ptr);
+
+                block->next = cache.free_lists[size_class];
+                cache.free_lists[size_class] = block;
+
+                if (++cache.free_counts[size_class] >= 2 * BATCH_SIZE) {
+                    get().put_batch(cache, size_class);
+                }
+
+                return;
+            } else if (kind == HeapKind::Arena && alignment <= CHUNK_ALIGNMENT) {
+                return;
+            }
+
+            if (HugePages::backs(bytes)) {
+                HugePages::deallocate(ptr, bytes);
+            } else if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                ::operator delete(ptr, std::align_val_t(alignment));
+            } else {
+                ::operator delete(ptr);
+            }
+        }
+
+        // Frees every chunk at once, no map may hold pool or arena memory anymore
+        auto release() -> void {
+            std::lock_guard<std::mutex> lock(this->mtx);
+
+            for (auto& chunk : this->chunks) {
+                if (HugePages::backs(chunk.second)) {
+                    HugePages::deallocate(chunk.first, chunk.second);
+                } else {
+                    ::operator delete(chunk.first, std::align_val_t(CHUNK_ALIGNMENT));
+                }
+            }
+
+            this->chunks.clear();
+            this->reserved.store(0, std::memory_order_relaxed);
+
+            for (auto& depot : this->depots) {
+                std::lock_guard<std::mutex> depot_lock(depot.mtx);
+                depot.batches.clear();
+            }
+
+            this->generation.fetch_add(1, std::memory_order_release);
+        }
+
+        // Bytes of chunks currently held, used or not
+        auto get_reserved() const -> uint64_t {
+            return this->reserved.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t MIN_CLASS = 16;
+        static constexpr size_t NUM_CLASSES = 9;               // 16 B to 4 KiB
+        static constexpr size_t CHUNK_SIZE = 1 << 20;
+        static constexpr size_t CHUNK_ALIGNMENT = 64;
+        static constexpr uint32_t BATCH_SIZE = 64;             // Blocks moved between a thread's list and the depot at once
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        struct ThreadCache {
+            uint64_t generation = 0;
+            char* cursor = nullptr;
+            char* end = nullptr;
+            FreeBlock* free_lists[NUM_CLASSES] = {};
+            uint32_t free_counts[NUM_CLASSES] = {};
+        };
+
+        // Full batches of freed blocks per size class, each a list of BATCH_SIZE blocks
+        struct Depot {
+            std::mutex mtx;
+            std::vector<FreeBlock*> batches;
+        };
+
+        static auto pooled(size_t bytes, size_t alignment) -> bool {
+            return bytes <= (MIN_CLASS << (NUM_CLASSES - 1)) && alignment <= MIN_CLASS;
+        }
+
+        // With huge pages a chunk fills one of them
+        static auto chunk_size() -> size_t {
+            return HugePages::backs(HugePages::HUGE_PAGE_SIZE) ? HugePages::HUGE_PAGE_SIZE : CHUNK_SIZE;
+        }
+
+        static auto class_of(size_t bytes) -> uint32_t {
+            uint32_t size_class = 0;
+            while ((MIN_CLASS << size_class) < bytes) {
+                size_class++;
+            }
+
+            return size_class;
+        }
+
+        static auto local() -> ThreadCache& {
+            static thread_local ThreadCache cache;
+            auto generation = get().generation.load(std::memory_order_acquire);
+
+            if (cache.generation != generation) {
+                cache = ThreadCache{};
+                cache.generation = generation;
+            }
+
+            return cache;
+        }
+
+        static auto bump(ThreadCache& cache, size_t bytes, size_t alignment) -> void* {
+            auto offset = cache.cursor != nullptr ? (alignment - reinterpret_cast<uintptr_t>(cache.cursor) % alignment) % alignment : 0;
+
+            if (cache.cursor == nullptr || bytes + offset > static_cast<size_t>(cache.end - cache.cursor)) {
+                cache.cursor = static_cast<char*>(get().chunk(chunk_size()));
+                cache.end = cache.cursor + chunk_size();
+                offset = 0;
+            }
+
+            auto ptr = cache.cursor + offset;
+            cache.cursor = ptr + bytes;
+            return ptr;
+        }
+
+        // Moves the first BATCH_SIZE blocks of the thread's list to the depot
+        auto put_batch(ThreadCache& cache, uint32_t size_class) -> void {
+            auto batch = cache.free_lists[size_class];
+            auto last = batch;
+
+            for (uint32_t i = 1; i < BATCH_SIZE; i++) {
+                last = last->next;
+            }
+
+            cache.free_lists[size_class] = last->next;
+            cache.free_counts[size_class] -= BATCH_SIZE;
+            last->next = nullptr;
+
+            auto& depot = this->depots[size_class];
+            std::lock_guard<std::mutex> lock(depot.mtx);
+            depot.batches.push_back(batch);
+        }
+
+        // Refills the thread's (empty) list from the depot, if it has a batch
+        auto take_batch(ThreadCache& cache, uint32_t size_class) -> void {
+            auto& depot = this->depots[size_class];
+            std::lock_guard<std::mutex> lock(depot.mtx);
+
+            if (!depot.batches.empty()) {
+                cache.free_lists[size_class] = depot.batches.back();
+                cache.free_counts[size_class] = BATCH_SIZE;
+                depot.batches.pop_back();
+            }
+        }
+
+        auto chunk(size_t bytes) -> void* {
+            auto ptr = HugePages::backs(bytes) ? HugePages::allocate(bytes) : ::operator new(bytes, std::align_val_t(CHUNK_ALIGNMENT));
+
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->chunks.emplace_back(ptr, bytes);
+            this->reserved.fetch_add(bytes, std::memory_order_relaxed);
+
+            return ptr;
+        }
+
+        std::mutex mtx;
+        std::vector<std::pair<void*, size_t>> chunks;
+        Depot depots[NUM_CLASSES];
+        std::atomic<uint64_t> reserved = 0;
+        std::atomic<uint64_t> generation = 1;
+};
+
+// Allocator for values a map only stores pointers to (Junction), not counted since Junction is measured by its RSS
+template<typename T>
+struct HeapAllocator {
+    using value_type = T;
+
+    HeapAllocator() noexcept = default;
+
+    template<typename U>
+    HeapAllocator(const HeapAllocator<U>&) noexcept {
+    }
+
+    auto allocate(size_t n) -> T* {
+        return static_cast<T*>(MapHeap::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    auto deallocate(T* ptr, size_t n) -> void {
+        MapHeap::deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    auto operator==(const HeapAllocator<U>&) const -> bool {
+        return true;
+    }
+
+    template<typename U>
+    auto operator!=(const HeapAllocator<U>&) const -> bool {
+        return false;
+    }
+};
+
+// new / delete of a single value through the map heap
+template<typename T, typename... Args>
+inline auto heap_new(Args&&... args) -> T* {
+    return new (HeapAllocator<T>{}.allocate(1)) T{ std::forward<Args>(args)... };
+}
+
+template<typename T>
+inline auto heap_delete(T* ptr) -> void {
+    ptr->~T();
+    HeapAllocator<T>{}.deallocate(ptr, 1);
+}
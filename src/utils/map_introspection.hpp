@@ -0,0 +1,191 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <libcuckoo/cuckoohash_map.hh>
+#include <tbb/concurrent_hash_map.h>
+#include <tbb/concurrent_unordered_map.h>
+#include "swiss_map.hpp"
+#include "../benchmarks/benchmark.hpp"
+
+// Layout of a map after a run, collected by a post-run pass with --introspect. Chained maps (std, TBB) have a bucket
+// per chain and a lookup compares the nodes of the key's chain up to the key. Open addressing maps have buckets of
+// fixed size (a Swiss table's groups of 16) and a lookup probes buckets. Maps only fill in what their library exposes:
+// libcuckoo just its buckets and load factor, Junction nothing at all.
+class MapStats {
+    public:
+        // Occupancies above this are counted with it
+        static constexpr uint64_t MAX_OCCUPANCY = 16;
+
+        // Toggled by --introspect, the pass walks the whole table and isn't free
+        static auto enabled() -> std::atomic<bool>& {
+            static std::atomic<bool> value = false;
+            return value;
+        }
+
+        MapStats() : occupancy(MAX_OCCUPANCY + 1) {
+        }
+
+        // A chain of the given length, its i-th node takes i comparisons to find
+        auto add_chain(uint64_t length) -> void {
+            this->num_entries += length;
+            this->num_buckets++;
+            this->num_slots++;
+            this->occupancy[std::min(length, MAX_OCCUPANCY)]++;
+
+            this->probe_total += length * (length + 1) / 2;
+            this->probe_max = std::max(this->probe_max, length);
+            this->num_probed += length;
+        }
+
+        // A bucket of num_slots slots, num_deleted of them holding tombstones
+        auto add_bucket(uint64_t num_full, uint64_t num_deleted, uint64_t num_slots) -> void {
+            this->num_entries += num_full;
+            this->num_deleted += num_deleted;
+            this->num_buckets++;
+            this->num_slots += num_slots;
+            this->occupancy[std::min(num_full, MAX_OCCUPANCY)]++;
+            this->open_addressing = true;
+        }
+
+        // An entry a lookup finds after probing num_probed buckets
+        auto add_probe(uint64_t num_probed) -> void {
+            this->probe_total += num_probed;
+            this->probe_max = std::max(this->probe_max, num_probed);
+            this->num_probed++;
+        }
+
+        // Buckets whose contents the map doesn't expose, only their number and size
+        auto add_opaque(uint64_t num_entries, uint64_t num_buckets, uint64_t slots_per_bucket) -> void {
+            this->num_entries += num_entries;
+            this->num_opaque += num_buckets;
+            this->num_buckets += num_buckets;
+            this->num_slots += num_buckets * slots_per_bucket;
+        }
+
+        auto report(RunResult& result) const -> void {
+            if (this->num_buckets == 0) {
+                return;
+            }
+
+            auto load_factor = this->num_slots > 0 ? static_cast<double>(this->num_entries) / this->num_slots : 0.0;
+
+            result.metrics["map_entries"] = this->num_entries;
+            result.metrics["map_buckets"] = this->num_buckets;
+            result.metrics["map_load_factor"] = load_factor;
+
+            std::cout << "Map layout: " << this->num_entries << " entries in " << this->num_buckets << " buckets, load factor " << load_factor;
+
+            // Partitioned runs may mix maps exposing their buckets with ones that don't, the histogram would be incomplete
+            if (this->num_opaque == 0) {
+                uint64_t highest = 0;
+                for (uint64_t i = 0; i <= MAX_OCCUPANCY; i++) {
+                    highest = this->occupancy[i] > 0 ? i : highest;
+                }
+
+                for (uint64_t i = 0; i <= highest; i++) {
+                    result.metrics["map_occupancy_" + std::to_string(i)] = this->occupancy[i];
+                }
+
+                result.metrics["map_empty_buckets"] = static_cast<double>(this->occupancy[0]) / this->num_buckets;
+            }
+
+            if (this->open_addressing && this->num_opaque == 0) {
+                result.metrics["map_deleted"] = this->num_deleted;
+            }
+
+            if (this->num_probed > 0) {
+                auto probe_avg = static_cast<double>(this->probe_total) / this->num_probed;
+
+                result.metrics["map_probe_avg"] = probe_avg;
+                result.metrics["map_probe_max"] = this->probe_max;
+
+                std::cout << ", " << probe_avg << " " << (this->open_addressing ? "buckets" : "nodes") << " probed on average (max " << this->probe_max << ")";
+            }
+
+            std::cout << std::endl;
+        }
+
+    private:
+        uint64_t num_entries = 0;
+        uint64_t num_buckets = 0;
+        uint64_t num_slots = 0;             // Entries the buckets hold at a load factor of 1, a chain counts as one
+        uint64_t num_deleted = 0;
+        uint64_t num_opaque = 0;
+        bool open_addressing = false;
+
+        std::vector<uint64_t> occupancy;    // Buckets by the number of entries they hold
+
+        uint64_t probe_total = 0;
+        uint64_t probe_max = 0;
+        uint64_t num_probed = 0;
+};
+
+template<typename K, typename V, typename Hash, typename Equal, typename Allocator>
+inline auto introspect_table(const std::unordered_map<K, V, Hash, Equal, Allocator>& map, MapStats& stats) -> void {
+    for (size_t i = 0; i < map.bucket_count(); i++) {
+        stats.add_chain(map.bucket_size(i));
+    }
+}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Allocator>
+inline auto introspect_table(const tbb::concurrent_unordered_map<K, V, Hash, Equal, Allocator>& map, MapStats& stats) -> void {
+    for (size_t i = 0; i < map.unsafe_bucket_count(); i++) {
+        stats.add_chain(map.unsafe_bucket_size(i));
+    }
+}
+
+// The chains aren't exposed, keys are counted into the bucket their hash masks to. Buckets the map didn't split yet
+// still hold the keys of their children, so this is the layout once every bucket has been rehashed.
+template<typename K, typename V, typename HashCompare, typename Allocator>
+inline auto introspect_table(const tbb::concurrent_hash_map<K, V, HashCompare, Allocator>& map, MapStats& stats) -> void {
+    std::vector<uint64_t> chains(map.bucket_count());
+    HashCompare compare;
+
+    for (auto& entry : map) {
+        chains[compare.hash(entry.first) & (chains.size() - 1)]++;
+    }
+
+    for (auto length : chains) {
+        stats.add_chain(length);
+    }
+}
+
+// Neither the slots in use nor the cuckoo paths of the inserts are exposed
+template<typename K, typename V, typename Hash, typename Equal, typename Allocator, std::size_t SLOT_PER_BUCKET>
+inline auto introspect_table(const libcuckoo::cuckoohash_map<K, V, Hash, Equal, Allocator, SLOT_PER_BUCKET>& map, MapStats& stats) -> void {
+    stats.add_opaque(map.size(), map.bucket_count(), map.slot_per_bucket());
+}
+
+template<typename K, typename V, typename Hash>
+inline auto introspect_table(const ConcurrentSwissMap<K, V, Hash>& map, MapStats& stats) -> void {
+    map.inspect([&](uint64_t num_full, uint64_t num_deleted, uint64_t num_slots) {
+        stats.add_bucket(num_full, num_deleted, num_slots);
+    }, [&](uint64_t num_probed) {
+        stats.add_probe(num_probed);
+    });
+}
+
+// Post-run pass over the benchmarked maps (one per partition in partitioned runs), once the workers are done
+template<typename It>
+inline auto introspect_maps(It begin, It end, RunResult& result) -> void {
+    if (!MapStats::enabled().load()) {
+        return;
+    }
+
+    MapStats stats;
+    for (auto it = begin; it != end; ++it) {
+        it->introspect(stats);
+    }
+
+    stats.report(result);
+}
+
+template<typename T>
+inline auto introspect_map(T& map, RunResult& result) -> void {
+    introspect_maps(&map, &map + 1, result);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include "counting_allocator.hpp"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Reads a "<field>: <value> kB" line from /proc/self/status, returns bytes (0 when unavailable)
+inline auto read_proc_status_bytes(const std::string& field) -> uint64_t {
+    std::ifstream file("/proc/self/status");
+
+    if (!file.is_open()) {
+        return 0;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, field.size(), field) == 0 && line.size() > field.size() && line[field.size()] == ':') {
+            return std::stoull(line.substr(field.size() + 1)) * 1024;
+        }
+    }
+
+    return 0;
+}
+
+inline auto get_rss() -> uint64_t {
+    return read_proc_status_bytes("VmRSS");
+}
+
+inline auto get_peak_rss() -> uint64_t {
+    return read_proc_status_bytes("VmHWM");
+}
+
+// Restarts VmHWM at the current RSS, so the peak of a single run can be read (Linux 4.0+)
+inline auto reset_peak_rss() -> bool {
+    std::ofstream file("/proc/self/clear_refs");
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "5";
+    file.flush();
+
+    return !file.fail();
+}
+
+// What a MemoryProbe measured, written into the run's metrics by report_memory() (benchmarks/memory_report.hpp)
+struct MemoryUsage {
+    bool measured = false;          // Only with --memory, the huge pages are read either way
+    bool counted = false;           // Whether the map allocated through the CountingAllocator, RSS growth otherwise
+    bool peak_rss_valid = false;
+
+    uint64_t allocated = 0;         // Including the untracked bytes
+    uint64_t allocated_peak = 0;
+    uint64_t rss = 0;
+    uint64_t rss_peak = 0;
+    uint64_t reserved = 0;
+    uint64_t huge_pages = 0;
+};
+
+// Memory used by the map of a single run. Maps using the CountingAllocator report the bytes they allocated,
+// the others (Junction) the growth of the RSS, which also includes freed memory the allocator kept around.
+class MemoryProbe {
+    public:
+        // Has to be created before the map
+        MemoryProbe() {
+            this->usage.measured = AllocationCounter::enabled().load();
+
+            if (!this->usage.measured) {
+                return;
+            }
+
+            auto& counter = AllocationCounter::get();
+            counter.reset_peak();
+            this->allocated_start = counter.get_current();
+
+#ifdef __GLIBC__
+            // Hand memory freed by the previous run back to the OS, otherwise the map would just reuse it without growing the RSS
+            malloc_trim(0);
+#endif
+
+            this->usage.peak_rss_valid = reset_peak_rss();
+            this->rss_start = get_rss();
+        }
+
+        // Memory the map holds outside of the CountingAllocator (the cache's value slabs). It's added to the allocated
+        // bytes, so counted maps compare with Junction, whose RSS growth includes it anyway. Call before finish()
+        auto add_untracked(uint64_t bytes) -> void {
+            this->untracked += bytes;
+        }
+
+        // Right after the run, while the map is still alive
+        auto finish() -> void {
+            // Read even without --memory, whether the pages were granted is what --hugepages is about
+            if (HugePages::mode().load() != HugePageMode::Off) {
+                this->usage.huge_pages = HugePages::get_backed_bytes();
+            }
+
+            if (!this->usage.measured) {
+                return;
+            }
+
+            auto& counter = AllocationCounter::get();
+            auto allocated_peak = counter.get_peak() - this->allocated_start;
+
+            this->usage.counted = allocated_peak > 0;
+            this->usage.allocated = counter.get_current() - this->allocated_start + this->untracked;
+            this->usage.allocated_peak = allocated_peak + this->untracked;
+
+            auto rss = get_rss();
+            auto peak_rss = this->usage.peak_rss_valid ? get_peak_rss() : 0;
+            this->usage.rss = rss - std::min(rss, this->rss_start);
+            this->usage.rss_peak = peak_rss - std::min(peak_rss, this->rss_start);
+            this->usage.reserved = MapHeap::get().get_reserved();
+        }
+
+        auto get_usage() const -> const MemoryUsage& {
+            return this->usage;
+        }
+
+    private:
+        MemoryUsage usage;
+
+        uint64_t allocated_start = 0;
+        uint64_t rss_start = 0;
+        uint64_t untracked = 0;
+};
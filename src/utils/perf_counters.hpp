@@ -0,0 +1,269 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include "../benchmarks/benchmark.hpp"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Per thread hardware counters, read through perf_event_open.
+// Counters only run between start() and stop(), around the timed region of a worker thread.
+// Events that can't be opened (no PMU in a VM, perf_event_paranoid, other platforms) are simply left out.
+
+enum class PerfEvent : uint32_t {
+    Cycles,
+    Instructions,
+    LLCMisses,
+    DTLBMisses,
+    BranchMisses,
+    ContextSwitches,
+    Count
+};
+
+constexpr uint32_t NUM_PERF_EVENTS = static_cast<uint32_t>(PerfEvent::Count);
+
+inline auto perf_event_name(uint32_t event) -> const char* {
+    constexpr const char* names[NUM_PERF_EVENTS] = {
+        "cycles",
+        "instructions",
+        "llc_misses",
+        "dtlb_misses",
+        "branch_misses",
+        "context_switches"
+    };
+
+    return names[event];
+}
+
+// Counter values of one or more threads, events nobody could count are marked invalid
+struct PerfSample {
+    std::array<uint64_t, NUM_PERF_EVENTS> values{};
+    std::array<bool, NUM_PERF_EVENTS> valid{};
+
+    auto operator+=(const PerfSample& other) -> PerfSample& {
+        for (uint32_t i = 0; i < NUM_PERF_EVENTS; i++) {
+            this->values[i] += other.values[i];
+            this->valid[i] = this->valid[i] || other.valid[i];
+        }
+
+        return *this;
+    }
+};
+
+class PerfCounters {
+    public:
+        // Toggled by --perf, counters are never opened otherwise
+        static auto enabled() -> std::atomic<bool>& {
+            static std::atomic<bool> value = false;
+            return value;
+        }
+
+        PerfCounters() {
+            this->fds.fill(-1);
+            this->leaders.fill(-1);
+
+            if (enabled().load()) {
+                this->open();
+            }
+        }
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (auto fd : this->fds) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+#endif
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        auto operator=(const PerfCounters&) -> PerfCounters& = delete;
+
+        auto start() -> void {
+#ifdef __linux__
+            for (auto fd : this->leaders) {
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+                }
+            }
+#endif
+        }
+
+        auto stop() -> void {
+#ifdef __linux__
+            for (auto fd : this->leaders) {
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+                }
+            }
+#endif
+        }
+
+        auto read() const -> PerfSample {
+            PerfSample sample{};
+
+#ifdef __linux__
+            for (uint32_t i = 0; i < NUM_PERF_EVENTS; i++) {
+                uint64_t data[3] = {};  // value, time enabled, time running
+
+                if (this->fds[i] < 0 || ::read(this->fds[i], data, sizeof(data)) != sizeof(data)) {
+                    continue;
+                }
+
+                // Scale up in case the kernel had to multiplex the counters
+                auto value = data[0];
+                if (data[2] > 0 && data[2] < data[1]) {
+                    value = static_cast<uint64_t>(static_cast<double>(value) * data[1] / data[2]);
+                }
+
+                sample.values[i] = value;
+                sample.valid[i] = true;
+            }
+#endif
+
+            return sample;
+        }
+
+    private:
+#ifdef __linux__
+        static auto event_config(uint32_t event, perf_event_attr& attr) -> void {
+            auto cache_miss = [](uint64_t cache) {
+                return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            };
+
+            switch (static_cast<PerfEvent>(event)) {
+                case PerfEvent::Cycles:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                    break;
+                case PerfEvent::Instructions:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                    break;
+                case PerfEvent::LLCMisses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+                    break;
+                case PerfEvent::DTLBMisses:
+                    attr.type = PERF_TYPE_HW_CACHE;
+                    attr.config = cache_miss(PERF_COUNT_HW_CACHE_DTLB);
+                    break;
+                case PerfEvent::BranchMisses:
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                    break;
+                default:
+                    attr.type = PERF_TYPE_SOFTWARE;
+                    attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+                    break;
+            }
+        }
+
+        static auto open_event(perf_event_attr& attr, int group_fd) -> int {
+            // Unprivileged users may only count user space (perf_event_paranoid >= 2)
+            for (auto exclude_kernel : { 0, 1 }) {
+                attr.exclude_kernel = exclude_kernel;
+                auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+
+                if (fd >= 0) {
+                    return fd;
+                }
+            }
+
+            return -1;
+        }
+
+        auto open() -> void {
+            // Hardware events share a group (scheduled onto the PMU together), the software event counts on it's own
+            int hardware_leader = -1;
+
+            for (uint32_t i = 0; i < NUM_PERF_EVENTS; i++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                attr.exclude_hv = 1;
+                event_config(i, attr);
+
+                auto hardware = attr.type != PERF_TYPE_SOFTWARE;
+                auto group_fd = hardware ? hardware_leader : -1;
+
+                // Only leaders start disabled, members follow their leader
+                attr.disabled = group_fd < 0;
+                this->fds[i] = open_event(attr, group_fd);
+
+                if (this->fds[i] >= 0 && group_fd < 0) {
+                    this->leaders[i] = this->fds[i];
+
+                    if (hardware) {
+                        hardware_leader = this->fds[i];
+                    }
+                }
+            }
+
+            warn_once(*this);
+        }
+#else
+        auto open() -> void {
+            warn_once(*this);
+        }
+#endif
+
+        static auto warn_once(const PerfCounters& counters) -> void {
+            static std::once_flag flag;
+
+            std::call_once(flag, [&counters]() {
+                for (uint32_t i = 0; i < NUM_PERF_EVENTS; i++) {
+                    if (counters.fds[i] < 0) {
+                        std::cerr << "Performance counter " << perf_event_name(i) << " is unavailable, continuing without it" << std::endl;
+                    }
+                }
+            });
+        }
+
+        std::array<int, NUM_PERF_EVENTS> fds{};
+        std::array<int, NUM_PERF_EVENTS> leaders{};
+};
+
+// Sums up the counters of all worker threads of a run
+class PerfTotals {
+    public:
+        auto add(const PerfSample& sample, uint64_t num_operations) -> void {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->sample += sample;
+            this->num_operations += num_operations;
+        }
+
+        // Adds perf_<event> (total) and perf_<event>_per_op for every event that could be counted
+        auto report(RunResult& result) const -> void {
+            for (uint32_t i = 0; i < NUM_PERF_EVENTS; i++) {
+                if (!this->sample.valid[i]) {
+                    continue;
+                }
+
+                auto name = std::string("perf_") + perf_event_name(i);
+                result.metrics[name] = static_cast<double>(this->sample.values[i]);
+                result.metrics[name + "_per_op"] = this->num_operations > 0 ? static_cast<double>(this->sample.values[i]) / this->num_operations : 0.0;
+            }
+
+            if (this->sample.valid[0] && this->sample.valid[1] && this->sample.values[0] > 0) {
+                result.metrics["perf_ipc"] = static_cast<double>(this->sample.values[1]) / this->sample.values[0];
+            }
+        }
+
+    private:
+        std::mutex mtx;
+        PerfSample sample{};
+        uint64_t num_operations = 0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include "timer.hpp"
+#include "../benchmarks/benchmark.hpp"
+
+// Start and end timepoints of every worker in a benchmark phase, taken by the workers themselves
+class PhaseTimes {
+    public:
+        // Created right before the workers of the phase are started (or handed their task by the pool)
+        PhaseTimes(uint32_t num_threads) : slots(num_threads), created(get_timepoint()) {
+        }
+
+        // Right after the worker was released
+        auto begin(uint32_t thread) -> void {
+            this->slots[thread].start = get_timepoint();
+        }
+
+        // Operations the worker has done so far, read by the ThroughputSampler. Each slot has a single writer, a plain store is enough
+        auto set_progress(uint32_t thread, uint64_t num_operations) -> void {
+            this->slots[thread].progress.store(num_operations, std::memory_order_relaxed);
+        }
+
+        auto get_progress() const -> uint64_t {
+            uint64_t total = 0;
+
+            for (auto& slot : this->slots) {
+                total += slot.progress.load(std::memory_order_relaxed);
+            }
+
+            return total;
+        }
+
+        auto get_progress(uint32_t thread) const -> uint64_t {
+            return this->slots[thread].progress.load(std::memory_order_relaxed);
+        }
+
+        // Right after the worker finished it's part
+        auto end(uint32_t thread) -> void {
+            this->slots[thread].end = get_end_timepoint();
+        }
+
+        // Adds the phase (relative to the main thread's timer) to the run, along with it's setup time (starting the workers),
+        // start skew (first to last worker starting) and straggler time (first to last worker finishing)
+        auto report(RunResult& result, const std::string& name, const Timer& timer) const -> void {
+            PhaseResult phase{ name, ::get_duration(timer.get_start(), timer.get_end()) };
+
+            uint64_t first_start = UINT64_MAX, last_start = 0;
+            uint64_t first_end = UINT64_MAX, last_end = 0;
+
+            for (auto& slot : this->slots) {
+                phase.thread_starts.push_back(::get_duration(timer.get_start(), slot.start));
+                phase.thread_ends.push_back(::get_duration(timer.get_start(), slot.end));
+
+                first_start = std::min(first_start, slot.start);
+                last_start = std::max(last_start, slot.start);
+                first_end = std::min(first_end, slot.end);
+                last_end = std::max(last_end, slot.end);
+            }
+
+            result.metrics[name + "_ns"] = phase.duration_ns;
+            result.metrics[name + "_setup_ns"] = ::get_duration(this->created, timer.get_start());
+
+            if (!this->slots.empty()) {
+                result.metrics[name + "_wakeup_ns"] = ::get_duration(timer.get_start(), first_start);
+                result.metrics[name + "_start_skew_ns"] = ::get_duration(first_start, last_start);
+                result.metrics[name + "_straggler_ns"] = ::get_duration(first_end, last_end);
+            }
+
+            result.phases.push_back(std::move(phase));
+        }
+
+    private:
+        // Workers write at the same moment, keep them on separate cache lines
+        struct alignas(64) Slot {
+            uint64_t start = 0;
+            uint64_t end = 0;
+            std::atomic<uint64_t> progress = 0;
+        };
+
+        std::vector<Slot> slots;
+        uint64_t created;
+};
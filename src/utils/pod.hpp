@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+// Fixed size key or value of N bytes, built from a 64 bit id. The first word is the id itself, the others are
+// derived from it, so two Pods are equal exactly when their ids are. Used to sweep entry sizes (--sizes).
+template<size_t N>
+struct Pod {
+    static_assert(N >= 8 && N % 8 == 0, "Pods are made of 64 bit words");
+    static constexpr size_t NUM_WORDS = N / 8;
+
+    uint64_t words[NUM_WORDS];
+
+    static auto from(uint64_t id) -> Pod {
+        Pod result;
+        result.words[0] = id;
+
+        for (size_t i = 1; i < NUM_WORDS; i++) {
+            result.words[i] = mix(id + i);
+        }
+
+        return result;
+    }
+
+    auto id() const -> uint64_t {
+        return this->words[0];
+    }
+
+    // Hashes every word, so longer keys cost more to hash like they would in a real map.
+    // 8 byte Pods hash like the plain integer keys they replace.
+    auto hash() const -> size_t {
+        if constexpr (NUM_WORDS == 1) {
+            return std::hash<uint64_t>{}(this->words[0]);
+        } else {
+            uint64_t hash = 0;
+
+            for (auto word : this->words) {
+                hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+                hash ^= hash >> 32;
+            }
+
+            return static_cast<size_t>(hash);
+        }
+    }
+
+    auto operator==(const Pod& other) const -> bool {
+        return std::memcmp(this->words, other.words, N) == 0;
+    }
+
+    auto operator!=(const Pod& other) const -> bool {
+        return !(*this == other);
+    }
+
+    // SplitMix64 finalizer
+    static auto mix(uint64_t x) -> uint64_t {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+};
+
+namespace std {
+    template<size_t N>
+    struct hash<Pod<N>> {
+        auto operator()(const Pod<N>& pod) const -> size_t {
+            return pod.hash();
+        }
+    };
+}
+
+// Sizes Pods are compiled for, calls f(std::integral_constant<size_t, size>) for one of them.
+// Returns false for any other size.
+template<typename F>
+inline auto visit_pod_size(uint32_t size, F&& f) -> bool {
+    switch (size) {
+        case 8: f(std::integral_constant<size_t, 8>{}); return true;
+        case 16: f(std::integral_constant<size_t, 16>{}); return true;
+        case 32: f(std::integral_constant<size_t, 32>{}); return true;
+        case 64: f(std::integral_constant<size_t, 64>{}); return true;
+        case 128: f(std::integral_constant<size_t, 128>{}); return true;
+        case 256: f(std::integral_constant<size_t, 256>{}); return true;
+    }
+
+    return false;
+}
+
+inline auto is_pod_size(uint32_t size) -> bool {
+    return visit_pod_size(size, [](auto) {});
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+#include "barrier.hpp"
+
+// Version counter of a sequence lock, odd while a writer holds it. Readers copy the guarded data between
+// read_begin() and read_retry() without writing anything, the copy is only valid if read_retry() returns false.
+class SeqlockVersion {
+    public:
+        // Waits until no writer holds the lock, returns the version to validate against
+        auto read_begin() const -> uint64_t {
+            auto version = this->version.load(std::memory_order_acquire);
+
+            while ((version & 1) != 0) {
+                cpu_relax();
+                version = this->version.load(std::memory_order_acquire);
+            }
+
+            return version;
+        }
+
+        // True if a writer got in since read_begin(), the copy has to be discarded
+        auto read_retry(uint64_t version) const -> bool {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return this->version.load(std::memory_order_relaxed) != version;
+        }
+
+        // Returns the (even) version before locking
+        auto lock() -> uint64_t {
+            auto version = this->version.load(std::memory_order_relaxed);
+
+            while ((version & 1) != 0 || !this->version.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                cpu_relax();
+                version = this->version.load(std::memory_order_relaxed);
+            }
+
+            // A reader seeing any of the following writes has to see the odd version as well
+            std::atomic_thread_fence(std::memory_order_release);
+            return version;
+        }
+
+        auto unlock(uint64_t version) -> void {
+            this->version.store(version + 2, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint64_t> version = 0;
+};
+
+// A value guarded by a sequence lock. Writers take turns through an odd version, readers copy the value
+// without writing anything and retry when a writer got in between, so readers never bounce the cache line.
+// The optimistic copy races with writers by design, only copies with an unchanged version are returned.
+template<typename T>
+class Seqlocked {
+    public:
+        static_assert(std::is_trivially_copyable_v<T>, "seqlocked values are copied with memcpy");
+
+        Seqlocked() = default;
+
+        explicit Seqlocked(const T& value) : value(value) {
+        }
+
+        auto load() const -> T {
+            T copy;
+
+            while (true) {
+                auto version = this->version.read_begin();
+                std::memcpy(&copy, &this->value, sizeof(T));
+
+                if (!this->version.read_retry(version)) {
+                    return copy;
+                }
+            }
+        }
+
+        // Calls f(value) while holding the write lock, returns what f returns
+        template<typename F>
+        auto modify(F&& f) -> decltype(f(std::declval<T&>())) {
+            auto version = this->version.lock();
+
+            if constexpr (std::is_void_v<decltype(f(std::declval<T&>()))>) {
+                f(this->value);
+                this->version.unlock(version);
+            } else {
+                auto result = f(this->value);
+                this->version.unlock(version);
+                return result;
+            }
+        }
+
+        auto store(const T& value) -> void {
+            this->modify([&](T& current) {
+                current = value;
+            });
+        }
+
+    private:
+        SeqlockVersion version;
+        T value{};
+};
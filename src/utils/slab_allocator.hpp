@@ -0,0 +1,235 @@
+#pragma once
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include "huge_pages.hpp"
+
+// Size class slab allocator with thread local magazines.
+// Chunks are carved from 1 MiB slabs (a 2 MiB huge page with --hugepages) which are only released when the allocator gets destroyed,
+// which keeps the memory type stable (a racing reader may see a reused chunk, but never unmapped memory).
+class SlabAllocator {
+    public:
+        static constexpr uint64_t SLAB_SIZE = 1 << 20;
+        static constexpr uint64_t SLAB_ALIGNMENT = 4096;
+        static constexpr uint64_t MIN_CHUNK = 16;
+        static constexpr uint64_t MAX_CHUNK = 64 * 1024;
+
+        struct Stats {
+            uint64_t num_allocations;   // Number of live allocations
+            uint64_t requested_bytes;   // Sum of requested sizes of live allocations
+            uint64_t chunk_bytes;       // Sum of chunk sizes of live allocations
+            uint64_t slab_bytes;        // Memory reserved by slabs
+        };
+
+        // Binds a magazine per size class to the calling thread, has to be destroyed before the allocator.
+        // Allocations from a thread without a cache go straight to the (locked) depot.
+        class ThreadCache {
+            public:
+                ThreadCache(SlabAllocator& allocator) : owner(allocator), magazines(allocator.classes.size()), previous(current()) {
+                    current() = this;
+                }
+
+                ~ThreadCache() {
+                    for (uint32_t i = 0; i < this->magazines.size(); i++) {
+                        this->owner.release(i, this->magazines[i], this->magazines[i].size());
+                    }
+
+                    this->owner.num_allocations.fetch_add(this->num_allocations);
+                    this->owner.requested_bytes.fetch_add(this->requested_bytes);
+                    this->owner.chunk_bytes.fetch_add(this->chunk_bytes);
+
+                    current() = this->previous;
+                }
+
+                ThreadCache(const ThreadCache&) = delete;
+                auto operator=(const ThreadCache&) -> ThreadCache& = delete;
+
+            private:
+                friend class SlabAllocator;
+
+                static auto current() -> ThreadCache*& {
+                    static thread_local ThreadCache* cache = nullptr;
+                    return cache;
+                }
+
+                SlabAllocator& owner;
+                std::vector<std::vector<void*>> magazines;
+                ThreadCache* previous;
+
+                // Kept locally and merged on destruction, wraps around while negative
+                uint64_t num_allocations = 0;
+                uint64_t requested_bytes = 0;
+                uint64_t chunk_bytes = 0;
+        };
+
+        SlabAllocator() : slab_size(HugePages::backs(HugePages::HUGE_PAGE_SIZE) ? HugePages::HUGE_PAGE_SIZE : SLAB_SIZE) {
+            // Roughly 4 classes per power of 2 keeps internal fragmentation under 25%,
+            // every class stays a multiple of 16 bytes so chunks are 16 byte aligned
+            for (uint64_t size = MIN_CHUNK; size <= MAX_CHUNK;) {
+                this->classes.push_back(size);
+                size += std::max<uint64_t>(MIN_CHUNK, (size / 4) & ~uint64_t(15));
+            }
+
+            this->depots = std::make_unique<Depot[]>(this->classes.size());
+        }
+
+        ~SlabAllocator() {
+            for (uint32_t i = 0; i < this->classes.size(); i++) {
+                for (auto slab : this->depots[i].slabs) {
+                    if (HugePages::backs(this->slab_size)) {
+                        HugePages::deallocate(slab, this->slab_size);
+                    } else {
+                        ::operator delete(slab, std::align_val_t(SLAB_ALIGNMENT));
+                    }
+                }
+            }
+        }
+
+        SlabAllocator(const SlabAllocator&) = delete;
+        auto operator=(const SlabAllocator&) -> SlabAllocator& = delete;
+
+        // Size must not exceed MAX_CHUNK
+        auto allocate(uint64_t size) -> void* {
+            auto size_class = this->class_of(size);
+            auto cache = this->local_cache();
+
+            if (!cache) {
+                std::vector<void*> chunks;
+                this->refill(size_class, chunks, 1);
+                this->num_allocations.fetch_add(1);
+                this->requested_bytes.fetch_add(size);
+                this->chunk_bytes.fetch_add(this->classes[size_class]);
+                return chunks.back();
+            }
+
+            auto& magazine = cache->magazines[size_class];
+            if (magazine.empty()) {
+                this->refill(size_class, magazine, this->batch_size(size_class));
+            }
+
+            cache->num_allocations++;
+            cache->requested_bytes += size;
+            cache->chunk_bytes += this->classes[size_class];
+
+            auto chunk = magazine.back();
+            magazine.pop_back();
+            return chunk;
+        }
+
+        auto deallocate(void* chunk, uint64_t size) -> void {
+            auto size_class = this->class_of(size);
+            auto cache = this->local_cache();
+
+            if (!cache) {
+                std::vector<void*> chunks{ chunk };
+                this->release(size_class, chunks, 1);
+                this->num_allocations.fetch_sub(1);
+                this->requested_bytes.fetch_sub(size);
+                this->chunk_bytes.fetch_sub(this->classes[size_class]);
+                return;
+            }
+
+            cache->num_allocations--;
+            cache->requested_bytes -= size;
+            cache->chunk_bytes -= this->classes[size_class];
+
+            // Keep at most two batches around, return one to the depot when full
+            auto& magazine = cache->magazines[size_class];
+            magazine.push_back(chunk);
+
+            auto batch = this->batch_size(size_class);
+            if (magazine.size() >= 2 * batch) {
+                this->release(size_class, magazine, batch);
+            }
+        }
+
+        // Size of the chunk backing an allocation of the given size
+        auto chunk_size(uint64_t size) const -> uint64_t {
+            return this->classes[this->class_of(size)];
+        }
+
+        // Only exact once all thread caches were destroyed
+        auto get_stats() const -> Stats {
+            return Stats{
+                this->num_allocations.load(),
+                this->requested_bytes.load(),
+                this->chunk_bytes.load(),
+                this->slab_bytes.load()
+            };
+        }
+
+    private:
+        struct Depot {
+            std::mutex mtx;
+            std::vector<void*> free_chunks;
+            std::vector<void*> slabs;
+
+            uint8_t* cursor = nullptr;
+            uint8_t* end = nullptr;
+        };
+
+        auto class_of(uint64_t size) const -> uint32_t {
+            auto it = std::lower_bound(this->classes.begin(), this->classes.end(), std::max<uint64_t>(size, 1));
+            return static_cast<uint32_t>(std::min<uint64_t>(it - this->classes.begin(), this->classes.size() - 1));
+        }
+
+        auto batch_size(uint32_t size_class) const -> uint64_t {
+            // Move roughly 64 KiB per depot trip
+            return std::clamp<uint64_t>((64 * 1024) / this->classes[size_class], 4, 64);
+        }
+
+        auto local_cache() const -> ThreadCache* {
+            auto cache = ThreadCache::current();
+            return (cache && &cache->owner == this) ? cache : nullptr;
+        }
+
+        auto refill(uint32_t size_class, std::vector<void*>& magazine, uint64_t count) -> void {
+            auto& depot = this->depots[size_class];
+            auto chunk_size = this->classes[size_class];
+
+            std::lock_guard<std::mutex> lock(depot.mtx);
+
+            while (count > 0 && !depot.free_chunks.empty()) {
+                magazine.push_back(depot.free_chunks.back());
+                depot.free_chunks.pop_back();
+                count--;
+            }
+
+            while (count > 0) {
+                if (depot.cursor + chunk_size > depot.end) {
+                    auto slab = static_cast<uint8_t*>(HugePages::backs(this->slab_size) ? HugePages::allocate(this->slab_size) : ::operator new(this->slab_size, std::align_val_t(SLAB_ALIGNMENT)));
+                    depot.slabs.push_back(slab);
+                    depot.cursor = slab;
+                    depot.end = slab + this->slab_size;
+                    this->slab_bytes.fetch_add(this->slab_size);
+                }
+
+                magazine.push_back(depot.cursor);
+                depot.cursor += chunk_size;
+                count--;
+            }
+        }
+
+        auto release(uint32_t size_class, std::vector<void*>& magazine, uint64_t count) -> void {
+            auto& depot = this->depots[size_class];
+            std::lock_guard<std::mutex> lock(depot.mtx);
+
+            for (; count > 0 && !magazine.empty(); count--) {
+                depot.free_chunks.push_back(magazine.back());
+                magazine.pop_back();
+            }
+        }
+
+        std::vector<uint64_t> classes;
+        std::unique_ptr<Depot[]> depots;
+
+        std::atomic<uint64_t> num_allocations = 0;
+        std::atomic<uint64_t> requested_bytes = 0;
+        std::atomic<uint64_t> chunk_bytes = 0;
+        std::atomic<uint64_t> slab_bytes = 0;
+        uint64_t slab_size;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+
+// Non owning view of contiguous elements, a stand-in for C++20's std::span
+template<typename T>
+class Span {
+    public:
+        Span(T* data, size_t size) : ptr(data), count(size) {
+        }
+
+        // Any contiguous container (std::vector, std::array, ...)
+        template<typename Container>
+        Span(Container& container) : ptr(container.data()), count(container.size()) {
+        }
+
+        auto begin() const -> T* {
+            return this->ptr;
+        }
+
+        auto end() const -> T* {
+            return this->ptr + this->count;
+        }
+
+        auto operator[](size_t index) const -> T& {
+            return this->ptr[index];
+        }
+
+        auto data() const -> T* {
+            return this->ptr;
+        }
+
+        auto size() const -> size_t {
+            return this->count;
+        }
+
+        auto empty() const -> bool {
+            return this->count == 0;
+        }
+
+    private:
+        T* ptr;
+        size_t count;
+};
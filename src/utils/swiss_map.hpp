@@ -0,0 +1,546 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include "seqlock.hpp"
+#include "counting_allocator.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Concurrent open addressing map in the style of Swiss tables. Slots are grouped by 16, every group has a control
+// byte per slot (empty, deleted or 7 bits of the key's hash) which are matched against the hash with a single SSE2
+// compare, so most lookups only touch one key. Every group also has a version (a seqlock): readers copy the control
+// bytes, keys and value without writing anything and retry when a writer changed the group in between. Writers of
+// the same key are serialized by striped locks, and lock each group they change. Growing locks all stripes and
+// rehashes the table in place to drop its deleted slots, readers retry on the map's rebuild version since entries
+// move between groups. Only doubling creates a new table, the old one is kept (and counted) until reclaim() since
+// readers may still be probing it.
+// Keys and values are copied while racing with writers, both have to be trivially copyable.
+template<typename K, typename V, typename Hash = std::hash<K>>
+class ConcurrentSwissMap {
+    public:
+        static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "keys and values are copied optimistically");
+
+        explicit ConcurrentSwissMap(uint64_t num_entries = 0) {
+            auto initial = this->create_table(num_groups_for(num_entries));
+
+            this->table.store(initial, std::memory_order_relaxed);
+            this->growth_left.store(static_cast<int64_t>(initial->num_groups * GROUP_SIZE * 7 / 8), std::memory_order_relaxed);
+        }
+
+        ~ConcurrentSwissMap() {
+            this->destroy_table(this->table.load());
+            this->reclaim();
+        }
+
+        ConcurrentSwissMap(const ConcurrentSwissMap&) = delete;
+        auto operator=(const ConcurrentSwissMap&) -> ConcurrentSwissMap& = delete;
+
+        auto find(const K& key, V& value) const -> bool {
+            auto hash = hash_of(key);
+
+            while (true) {
+                auto version = this->rebuild.read_begin();
+                auto current = this->table.load(std::memory_order_acquire);
+                auto position = find_in(current, key, hash, value);
+
+                // A rebuild or resize got in between, the entry may have moved to a group that was already probed
+                if (!this->rebuild.read_retry(version) && this->table.load(std::memory_order_acquire) == current) {
+                    return position != NOT_FOUND;
+                }
+            }
+        }
+
+        // Inserts the entry if the key is absent, returns false (and leaves the map as it is) otherwise
+        auto insert(const K& key, const V& value) -> bool {
+            return this->insert_or_modify(key, value, [](V&) {});
+        }
+
+        // Inserts the entry if the key is absent, otherwise calls modify(value) with the group locked. Returns true if inserted.
+        template<typename F>
+        auto insert_or_modify(const K& key, const V& value, F&& modify) -> bool {
+            auto hash = hash_of(key);
+            auto& stripe = this->stripes[stripe_of(hash)];
+
+            while (true) {
+                std::unique_lock<std::mutex> lock(stripe.mtx);
+                auto current = this->table.load(std::memory_order_relaxed);
+
+                // Nobody else writes this key, a slot holding it stays where it is
+                V existing;
+                auto position = find_in(current, key, hash, existing);
+
+                if (position != NOT_FOUND) {
+                    auto& group = current->groups[position / GROUP_SIZE];
+                    auto version = group.version.lock();
+                    modify(current->slots[position].value);
+                    group.version.unlock(version);
+                    return false;
+                }
+
+                // Reserve room for the entry, or grow first
+                if (this->growth_left.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+                    this->growth_left.fetch_add(1, std::memory_order_relaxed);
+                    lock.unlock();
+                    this->grow();
+                    continue;
+                }
+
+                this->claim(current, key, value, hash);
+                this->size.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Removes the entry if pred(value) holds, copying its value to removed
+        template<typename F>
+        auto erase_if(const K& key, F&& pred, V& removed) -> bool {
+            auto hash = hash_of(key);
+            std::lock_guard<std::mutex> lock(this->stripes[stripe_of(hash)].mtx);
+
+            auto current = this->table.load(std::memory_order_relaxed);
+            auto position = find_in(current, key, hash, removed);
+            if (position == NOT_FOUND) {
+                return false;
+            }
+
+            auto& group = current->groups[position / GROUP_SIZE];
+            auto index = position % GROUP_SIZE;
+            auto version = group.version.lock();
+            auto& slot = current->slots[position];
+
+            if (!pred(slot.value)) {
+                group.version.unlock(version);
+                return false;
+            }
+
+            removed = slot.value;
+
+            // Probes stop at groups with an empty slot, one more empty slot there doesn't cut any probe sequence short
+            if (match_empty(group.control) != 0) {
+                group.control[index] = EMPTY;
+                this->growth_left.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                group.control[index] = DELETED;
+            }
+
+            group.version.unlock(version);
+            this->size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        auto erase(const K& key, V& removed) -> bool {
+            return this->erase_if(key, [](const V&) { return true; }, removed);
+        }
+
+        // Calls f(key, value) for every entry, only while no one else is using the map
+        template<typename F>
+        auto for_each(F&& f) -> void {
+            auto current = this->table.load();
+
+            for (uint64_t i = 0; i < current->num_groups * GROUP_SIZE; i++) {
+                if (current->groups[i / GROUP_SIZE].control[i % GROUP_SIZE] >= 0) {
+                    f(current->slots[i].key, current->slots[i].value);
+                }
+            }
+        }
+
+        auto get_size() const -> uint64_t {
+            return this->size.load(std::memory_order_relaxed);
+        }
+
+        // Frees the tables replaced by doubling, only while no one else is using the map (between phases)
+        auto reclaim() -> void {
+            for (auto old : this->retired) {
+                this->destroy_table(old);
+            }
+
+            this->retired.clear();
+        }
+
+        // Slots of the current table
+        auto get_capacity() const -> uint64_t {
+            return this->table.load(std::memory_order_acquire)->num_groups * GROUP_SIZE;
+        }
+
+        // Layout of the current table, only while no one else is using the map. Calls on_group(full, deleted, slots) with
+        // the slot counts of every group, and on_entry(groups) with the number of groups a lookup of the entry probes.
+        template<typename G, typename E>
+        auto inspect(G&& on_group, E&& on_entry) const -> void {
+            auto current = this->table.load();
+
+            for (uint64_t index = 0; index < current->num_groups; index++) {
+                auto& group = current->groups[index];
+                uint32_t num_full = 0, num_deleted = 0;
+
+                for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+                    if (group.control[i] < 0) {
+                        num_deleted += group.control[i] == DELETED ? 1 : 0;
+                        continue;
+                    }
+
+                    num_full++;
+                    uint64_t num_probed = 0;
+
+                    probe(current, hash_of(current->slots[index * GROUP_SIZE + i].key), [&](const Group&, uint64_t probed) {
+                        num_probed++;
+                        return probed != index;
+                    });
+
+                    on_entry(num_probed);
+                }
+
+                on_group(num_full, num_deleted, GROUP_SIZE);
+            }
+        }
+
+    private:
+        static constexpr uint32_t GROUP_SIZE = 16;
+        static constexpr uint32_t NUM_STRIPES = 256;
+        static constexpr uint64_t MIN_GROUPS = 4;
+        static constexpr uint64_t NOT_FOUND = UINT64_MAX;
+
+        // Full slots hold the 7 bit hash, so only the control bytes of empty and deleted slots are negative
+        static constexpr int8_t EMPTY = -128;
+        static constexpr int8_t DELETED = -2;
+
+        struct alignas(32) Group {
+            int8_t control[GROUP_SIZE];
+            SeqlockVersion version;
+        };
+
+        struct Slot {
+            K key;
+            V value;
+        };
+
+        struct Table {
+            uint64_t num_groups;            // A power of 2
+            Group* groups;
+            Slot* slots;
+        };
+
+        struct alignas(64) Stripe {
+            std::mutex mtx;
+        };
+
+        // The lower bits pick the group, the upper 7 are stored in the control byte
+        static auto hash_of(const K& key) -> uint64_t {
+            uint64_t hash = Hash{}(key);
+
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ull;
+            hash ^= hash >> 33;
+
+            return hash;
+        }
+
+        static auto tag_of(uint64_t hash) -> int8_t {
+            return static_cast<int8_t>(hash >> 57);
+        }
+
+        static auto stripe_of(uint64_t hash) -> uint32_t {
+            return static_cast<uint32_t>(hash >> 40) % NUM_STRIPES;
+        }
+
+        // Room for num_entries at a load factor of at most 7/8
+        static auto num_groups_for(uint64_t num_entries) -> uint64_t {
+            uint64_t num_groups = MIN_GROUPS;
+            while (num_groups * GROUP_SIZE * 7 / 8 < num_entries) {
+                num_groups *= 2;
+            }
+
+            return num_groups;
+        }
+
+        // Bit i is set if control byte i equals tag
+        static auto match(const int8_t* control, int8_t tag) -> uint32_t {
+#if defined(__SSE2__) || defined(_M_X64)
+            auto group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), group)));
+#else
+            uint32_t mask = 0;
+            for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+                mask |= (control[i] == tag ? 1u : 0u) << i;
+            }
+
+            return mask;
+#endif
+        }
+
+        static auto match_empty(const int8_t* control) -> uint32_t {
+            return match(control, EMPTY);
+        }
+
+        // Empty or deleted, the only control bytes with the sign bit set
+        static auto match_free(const int8_t* control) -> uint32_t {
+#if defined(__SSE2__) || defined(_M_X64)
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(control))));
+#else
+            uint32_t mask = 0;
+            for (uint32_t i = 0; i < GROUP_SIZE; i++) {
+                mask |= (control[i] < 0 ? 1u : 0u) << i;
+            }
+
+            return mask;
+#endif
+        }
+
+        static auto lowest_bit(uint32_t mask) -> uint32_t {
+#ifdef _MSC_VER
+            unsigned long index = 0;
+            _BitScanForward(&index, mask);
+            return index;
+#else
+            return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+        }
+
+        // Triangular probing, visits every group once since the number of groups is a power of 2
+        template<typename F>
+        static auto probe(const Table* table, uint64_t hash, F&& visit) -> void {
+            auto mask = table->num_groups - 1;
+            auto group = hash & mask;
+
+            for (uint64_t step = 1; step <= table->num_groups; step++) {
+                if (!visit(table->groups[group], group)) {
+                    return;
+                }
+
+                group = (group + step) & mask;
+            }
+        }
+
+        // Position of the key's slot (group * 16 + slot) and a copy of its value, or NOT_FOUND
+        static auto find_in(const Table* table, const K& key, uint64_t hash, V& value) -> uint64_t {
+            auto tag = tag_of(hash);
+            auto position = NOT_FOUND;
+
+            probe(table, hash, [&](const Group& group, uint64_t index) {
+                while (true) {
+                    auto version = group.version.read_begin();
+
+                    int8_t control[GROUP_SIZE];
+                    std::memcpy(control, group.control, GROUP_SIZE);
+
+                    for (auto matches = match(control, tag); matches != 0; matches &= matches - 1) {
+                        auto& slot = table->slots[index * GROUP_SIZE + lowest_bit(matches)];
+
+                        K candidate;
+                        std::memcpy(&candidate, &slot.key, sizeof(K));
+
+                        if (candidate == key) {
+                            std::memcpy(&value, &slot.value, sizeof(V));
+                            position = index * GROUP_SIZE + lowest_bit(matches);
+                            break;
+                        }
+                    }
+
+                    if (group.version.read_retry(version)) {
+                        position = NOT_FOUND;
+                        continue;
+                    }
+
+                    // Stop once found, or at the first group with an empty slot
+                    return position == NOT_FOUND && match_empty(control) == 0;
+                }
+            });
+
+            return position;
+        }
+
+        // Writes the entry into the first free slot of the key's probe sequence, room has been reserved already
+        auto claim(Table* table, const K& key, const V& value, uint64_t hash) -> void {
+            probe(table, hash, [&](Group& group, uint64_t index) {
+                if (match_free(group.control) == 0) {
+                    return true;
+                }
+
+                auto version = group.version.lock();
+                auto free = match_free(group.control);
+
+                // Taken by a writer of another stripe in the meantime
+                if (free == 0) {
+                    group.version.unlock(version);
+                    return true;
+                }
+
+                auto slot = lowest_bit(free);
+                if (group.control[slot] == DELETED) {
+                    this->growth_left.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                table->slots[index * GROUP_SIZE + slot] = Slot{ key, value };
+                group.control[slot] = tag_of(hash);
+                group.version.unlock(version);
+                return false;
+            });
+        }
+
+        // Makes room for inserts, unless another writer already did. As long as the entries leave at least 1/64 of the
+        // slots for inserts the table is rehashed in place without its deleted slots, so that comes at most every
+        // num_slots / 64 inserts. It doubles otherwise, which under churn at a constant size happens at most once.
+        auto grow() -> void {
+            for (auto& stripe : this->stripes) {
+                stripe.mtx.lock();
+            }
+
+            if (this->growth_left.load(std::memory_order_relaxed) <= 0) {
+                auto current = this->table.load(std::memory_order_relaxed);
+                auto size = this->size.load(std::memory_order_relaxed);
+                auto num_slots = current->num_groups * GROUP_SIZE;
+
+                if ((size + 1) * 64 > num_slots * 55) {
+                    auto next = this->create_table(current->num_groups * 2);
+
+                    for (uint64_t i = 0; i < num_slots; i++) {
+                        if (current->groups[i / GROUP_SIZE].control[i % GROUP_SIZE] >= 0) {
+                            auto hash = hash_of(current->slots[i].key);
+                            auto target = first_free(next, hash);
+
+                            next->slots[target] = current->slots[i];
+                            next->groups[target / GROUP_SIZE].control[target % GROUP_SIZE] = tag_of(hash);
+                        }
+                    }
+
+                    this->table.store(next, std::memory_order_release);
+                    this->retired.push_back(current);
+                } else {
+                    this->rehash_in_place(current);
+                }
+
+                auto next = this->table.load(std::memory_order_relaxed);
+                this->growth_left.store(static_cast<int64_t>(next->num_groups * GROUP_SIZE * 7 / 8 - size), std::memory_order_relaxed);
+            }
+
+            for (auto& stripe : this->stripes) {
+                stripe.mtx.unlock();
+            }
+        }
+
+        // Drops the deleted slots without a second table, all stripes are held. Full slots are marked deleted and then
+        // put back one by one: an entry stays in its group if that is the first of its probe sequence with a free slot,
+        // moves to an empty slot, or swaps with a deleted (not yet placed) one which is placed next. A group only
+        // gets an empty slot once the entry leaving it is placed, and none of the placed entries could have probed
+        // past it, so no probe sequence is cut short.
+        auto rehash_in_place(Table* table) -> void {
+            auto num_slots = table->num_groups * GROUP_SIZE;
+            auto rebuild_version = this->rebuild.lock();
+            std::vector<uint64_t> versions(table->num_groups);
+
+            // Readers of a group retry until it's done, readers across groups retry on the rebuild version
+            for (uint64_t i = 0; i < table->num_groups; i++) {
+                versions[i] = table->groups[i].version.lock();
+
+                for (auto& control : table->groups[i].control) {
+                    control = control >= 0 ? DELETED : EMPTY;
+                }
+            }
+
+            for (uint64_t i = 0; i < num_slots; i++) {
+                auto& control = table->groups[i / GROUP_SIZE].control[i % GROUP_SIZE];
+                if (control != DELETED) {
+                    continue;
+                }
+
+                auto hash = hash_of(table->slots[i].key);
+                auto target = first_free(table, hash);
+                auto& target_control = table->groups[target / GROUP_SIZE].control[target % GROUP_SIZE];
+
+                if (target / GROUP_SIZE == i / GROUP_SIZE) {
+                    control = tag_of(hash);
+                } else if (target_control == EMPTY) {
+                    table->slots[target] = table->slots[i];
+                    target_control = tag_of(hash);
+                    control = EMPTY;
+                } else {
+                    std::swap(table->slots[target], table->slots[i]);
+                    target_control = tag_of(hash);
+                    i--;
+                }
+            }
+
+            for (uint64_t i = 0; i < table->num_groups; i++) {
+                table->groups[i].version.unlock(versions[i]);
+            }
+
+            this->rebuild.unlock(rebuild_version);
+        }
+
+        // Position of the first empty or deleted slot of the hash's probe sequence, only while all stripes are held
+        static auto first_free(Table* table, uint64_t hash) -> uint64_t {
+            auto position = NOT_FOUND;
+
+            probe(table, hash, [&](Group& group, uint64_t index) {
+                auto free = match_free(group.control);
+                if (free == 0) {
+                    return true;
+                }
+
+                position = index * GROUP_SIZE + lowest_bit(free);
+                return false;
+            });
+
+            return position;
+        }
+
+        auto create_table(uint64_t num_groups) -> Table* {
+            auto table = new Table{ num_groups, CountingAllocator<Group>{}.allocate(num_groups), CountingAllocator<Slot>{}.allocate(num_groups * GROUP_SIZE) };
+
+            for (uint64_t i = 0; i < num_groups; i++) {
+                auto group = new (&table->groups[i]) Group{};
+                std::memset(group->control, EMPTY, GROUP_SIZE);
+            }
+
+            return table;
+        }
+
+        auto destroy_table(Table* table) -> void {
+            for (uint64_t i = 0; i < table->num_groups; i++) {
+                table->groups[i].~Group();
+            }
+
+            CountingAllocator<Group>{}.deallocate(table->groups, table->num_groups);
+            CountingAllocator<Slot>{}.deallocate(table->slots, table->num_groups * GROUP_SIZE);
+            delete table;
+        }
+
+        std::atomic<Table*> table;
+        std::vector<Table*> retired;
+        SeqlockVersion rebuild;                                 // Held while entries move between groups of the table
+
+        Stripe stripes[NUM_STRIPES];
+
+        alignas(64) std::atomic<int64_t> growth_left = 0;       // Empty slots which may still be used before growing
+        alignas(64) std::atomic<uint64_t> size = 0;
+};
+
+// Frees what a map keeps for racing readers (the Swiss table's replaced tables), a no-op for maps without reclaim().
+// Called by the benchmarks once a phase is over.
+template<typename T>
+inline auto reclaim_map(T& map, int) -> decltype(map.reclaim(), void()) {
+    map.reclaim();
+}
+
+template<typename T>
+inline auto reclaim_map(T&, long) -> void {
+}
+
+template<typename T>
+inline auto reclaim_map(T& map) -> void {
+    reclaim_map(map, 0);
+}
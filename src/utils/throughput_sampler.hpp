@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include "timer.hpp"
+#include "phase_times.hpp"
+#include "../benchmarks/benchmark.hpp"
+
+// Samples the workers' progress counters every few ms while a phase runs, turning them into an
+// ops/s time series that shows resize stalls, cleaner pauses or migrations hidden by the run's total.
+// The sampler thread is left unpinned and sleeps between samples, workers only pay for a relaxed store per update.
+class ThroughputSampler {
+    public:
+        // Set by --sample-ms, 0 disables sampling
+        static auto interval_ms() -> std::atomic<uint32_t>& {
+            static std::atomic<uint32_t> value = 0;
+            return value;
+        }
+
+        ThroughputSampler(const PhaseTimes& times) : times(times), interval(interval_ms().load()) {
+        }
+
+        ~ThroughputSampler() {
+            this->stop();
+        }
+
+        ThroughputSampler(const ThroughputSampler&) = delete;
+        auto operator=(const ThroughputSampler&) -> ThroughputSampler& = delete;
+
+        // Right after the workers were released, samples are relative to the given timepoint
+        auto start(uint64_t start_timepoint) -> void {
+            if (this->interval == 0) {
+                return;
+            }
+
+            this->start_timepoint = start_timepoint;
+            this->running = true;
+            this->thread = std::thread(&ThroughputSampler::sample, this);
+        }
+
+        // After all workers finished, takes a last (shorter) sample
+        auto stop() -> void {
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->running = false;
+            }
+
+            this->var.notify_all();
+
+            if (this->thread.joinable()) {
+                this->thread.join();
+            }
+        }
+
+        auto report(RunResult& result, const std::string& name) const -> void {
+            if (this->interval == 0) {
+                return;
+            }
+
+            result.timeseries.push_back(TimeSeries{ name, this->interval, "ops/s", this->time_ns, this->ops_per_sec });
+        }
+
+    private:
+        auto sample() -> void {
+            auto last_timepoint = this->start_timepoint;
+            uint64_t last_progress = 0;
+            bool running = true;
+
+            while (running) {
+                {
+                    std::unique_lock<std::mutex> lock(this->mtx);
+                    running = !this->var.wait_for(lock, std::chrono::milliseconds(this->interval), [this]() { return !this->running; });
+                }
+
+                auto timepoint = get_timepoint();
+                auto progress = this->times.get_progress();
+                auto elapsed = get_duration(last_timepoint, timepoint);
+
+                if (elapsed == 0) {
+                    continue;
+                }
+
+                this->time_ns.push_back(get_duration(this->start_timepoint, timepoint));
+                this->ops_per_sec.push_back(static_cast<uint64_t>((progress - last_progress) * 1e9 / elapsed));
+
+                last_timepoint = timepoint;
+                last_progress = progress;
+            }
+        }
+
+        const PhaseTimes& times;
+        uint32_t interval;
+        uint64_t start_timepoint = 0;
+
+        std::thread thread;
+        std::mutex mtx;
+        std::condition_variable var;
+        bool running = false;
+
+        std::vector<uint64_t> time_ns;
+        std::vector<uint64_t> ops_per_sec;
+};
@@ -1,67 +1,161 @@
 #pragma once
 #include <cstdint>
+#include <string>
 
 #ifdef _WIN32
 #define NOMINMAX
 #include <Windows.h>
+#else
+#include <time.h>
+#endif
 
-auto get_timepoint() -> uint64_t {
-    LARGE_INTEGER timepoint{};
-    QueryPerformanceCounter(&timepoint);
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define HAS_TSC_TIMER
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+
+// Timepoints are raw ticks, either of the invariant TSC (calibrated once against the OS clock)
+// or of the OS clock itself (clock_gettime / QueryPerformanceCounter). Define NO_TSC_TIMER to always use the OS clock.
+class Clock {
+    public:
+        static auto get() -> const Clock& {
+            static Clock clock;
+            return clock;
+        }
 
-    return timepoint.QuadPart;
-}
+        auto now() const -> uint64_t {
+#ifdef HAS_TSC_TIMER
+            if (this->tsc) {
+                return __rdtsc();
+            }
+#endif
+            return os_now();
+        }
 
-auto get_duration(uint64_t start_timepoint, uint64_t end_timepoint) -> uint64_t {
-    LARGE_INTEGER frequency{};
-    QueryPerformanceFrequency(&frequency);
+        // Like now(), but waits for all previous instructions to finish (rdtscp), used to end measurements
+        auto now_end() const -> uint64_t {
+#ifdef HAS_TSC_TIMER
+            if (this->tsc) {
+                unsigned int aux;
+                return __rdtscp(&aux);
+            }
+#endif
+            return os_now();
+        }
 
-    uint64_t ns_per_count = (uint64_t)1e9 / frequency.QuadPart;
+        auto to_ns(uint64_t ticks) const -> uint64_t {
+            return static_cast<uint64_t>(ticks * this->ns_per_tick);
+        }
 
-    auto difference = end_timepoint - start_timepoint;
-    return difference * ns_per_count;
-}
+        auto uses_tsc() const -> bool {
+            return this->tsc;
+        }
 
-class Timer {
-    public:
-        auto start() -> void {
-            this->start_ns = get_timepoint();
-            this->end_ns = this->start_ns;
-            this->running = true;
+        auto get_name() const -> std::string {
+            return this->tsc ? "tsc" : "os";
         }
 
-        auto end() -> void {
-            this->end_ns = get_timepoint();
-            this->running = false;
+        auto get_ns_per_tick() const -> double {
+            return this->ns_per_tick;
         }
 
-        auto get_duration() -> uint64_t {
-            if (this->running) {
-                this->end();
-                this->running = true;
+    private:
+        Clock() {
+            this->ns_per_tick = os_ns_per_tick();
+
+#ifdef HAS_TSC_TIMER
+#ifndef NO_TSC_TIMER
+            if (has_invariant_tsc()) {
+                // Calibrate for 10 ms against the OS clock
+                auto os_start = os_now();
+                auto tsc_start = __rdtsc();
+
+                while ((os_now() - os_start) * this->ns_per_tick < 10000000.0) {
+                }
+
+                auto os_end = os_now();
+                auto tsc_end = __rdtsc();
+
+                if (tsc_end > tsc_start) {
+                    this->ns_per_tick = (os_end - os_start) * this->ns_per_tick / (tsc_end - tsc_start);
+                    this->tsc = true;
+                }
+            }
+#endif
+#endif
+        }
+
+#ifdef HAS_TSC_TIMER
+        // The TSC has to tick at a constant rate and keep ticking in deep C-states (CPUID 0x80000007, EDX bit 8)
+        static auto has_invariant_tsc() -> bool {
+#ifdef _MSC_VER
+            int regs[4] = {};
+            __cpuid(regs, 0x80000000);
+            if (static_cast<unsigned int>(regs[0]) < 0x80000007) {
+                return false;
+            }
+
+            __cpuid(regs, 0x80000007);
+            return (regs[3] & (1 << 8)) != 0;
+#else
+            unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+                return false;
             }
 
-            return ::get_duration(this->start_ns, this->end_ns);
+            return (edx & (1 << 8)) != 0;
+#endif
         }
+#endif
 
-        auto is_running() -> bool {
-            return this->running;
+        static auto os_now() -> uint64_t {
+#ifdef _WIN32
+            LARGE_INTEGER timepoint{};
+            QueryPerformanceCounter(&timepoint);
+
+            return timepoint.QuadPart;
+#else
+            timespec time{};
+            clock_gettime(CLOCK_MONOTONIC, &time);
+
+            return static_cast<uint64_t>(time.tv_sec) * 1000000000ull + time.tv_nsec;
+#endif
         }
 
-    private:
-        uint64_t start_ns = 0;
-        uint64_t end_ns = 0;
-        bool running = true;
-};
+        static auto os_ns_per_tick() -> double {
+#ifdef _WIN32
+            LARGE_INTEGER frequency{};
+            QueryPerformanceFrequency(&frequency);
+
+            return 1e9 / frequency.QuadPart;
 #else
-#include <chrono>
+            return 1.0;
+#endif
+        }
+
+        bool tsc = false;
+        double ns_per_tick = 1.0;
+};
+
+inline auto get_timepoint() -> uint64_t {
+    return Clock::get().now();
+}
 
-auto get_timepoint() -> std::chrono::time_point<std::chrono::high_resolution_clock> {
-    return std::chrono::high_resolution_clock::now();
+inline auto get_end_timepoint() -> uint64_t {
+    return Clock::get().now_end();
 }
 
-auto get_duration(uint64_t start_timepoint, uint64_t end_timepoint) -> uint64_t {
-    return end_timepoint - start_timepoint
+inline auto get_duration(uint64_t start_timepoint, uint64_t end_timepoint) -> uint64_t {
+    if (end_timepoint <= start_timepoint) {
+        return 0;
+    }
+
+    return Clock::get().to_ns(end_timepoint - start_timepoint);
 }
 
 class Timer {
@@ -72,8 +166,20 @@ class Timer {
             this->running = true;
         }
 
+        // Starts at an already taken timepoint, e.g. the moment a barrier released the workers
+        auto start_at(uint64_t timepoint) -> void {
+            this->start_pt = timepoint;
+            this->end_pt = timepoint;
+            this->running = true;
+        }
+
+        auto end_at(uint64_t timepoint) -> void {
+            this->end_pt = timepoint;
+            this->running = false;
+        }
+
         auto end() -> void {
-            this->end_pt = get_timepoint();
+            this->end_pt = get_end_timepoint();
             this->running = false;
         }
 
@@ -83,16 +189,23 @@ class Timer {
                 this->running = true;
             }
 
-            return this->end_pt - this->start_pt
+            return ::get_duration(this->start_pt, this->end_pt);
         }
 
         auto is_running() -> bool {
             return this->running;
         }
 
+        auto get_start() const -> uint64_t {
+            return this->start_pt;
+        }
+
+        auto get_end() const -> uint64_t {
+            return this->end_pt;
+        }
+
     private:
-        std::chrono::time_point<std::chrono::high_resolution_clock> start_pt{};
-        std::chrono::time_point<std::chrono::high_resolution_clock> end_pt{};
+        uint64_t start_pt = 0;
+        uint64_t end_pt = 0;
         bool running = true;
 };
-#endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "affinity.hpp"
+
+// Persistent worker threads, one per thread slot, created on first use and pinned once.
+// Runs and phases hand their work to the same threads, so thread creation, fresh stacks and
+// changing cpus don't end up in the measurements.
+class WorkerPool {
+    public:
+        // Toggled off by --fresh-threads, every task then gets a new thread like before
+        static auto enabled() -> std::atomic<bool>& {
+            static std::atomic<bool> value = true;
+            return value;
+        }
+
+        // Slot of the calling worker, -1 outside of the pool
+        static auto slot() -> int32_t& {
+            thread_local int32_t value = -1;
+            return value;
+        }
+
+        // Storage of the calling worker. A pooled worker is the only thread of its slot, so this is the slot's storage and
+        // is kept across runs and phases. With --fresh-threads every task gets a new thread, which starts from T{} again.
+        template<typename T>
+        static auto local() -> T& {
+            thread_local T value{};
+            return value;
+        }
+
+        WorkerPool() = default;
+
+        ~WorkerPool() {
+            for (auto& worker : this->workers) {
+                {
+                    std::lock_guard<std::mutex> lock(worker->mtx);
+                    worker->stop = true;
+                }
+
+                worker->var.notify_one();
+                worker->thread.join();
+            }
+        }
+
+        WorkerPool(const WorkerPool&) = delete;
+        auto operator=(const WorkerPool&) -> WorkerPool& = delete;
+
+        // Only called by the main thread, a slot runs a single task at a time
+        auto execute(uint32_t slot, std::function<void()> task) -> void {
+            while (this->workers.size() <= slot) {
+                auto worker = std::make_unique<Worker>();
+                worker->thread = std::thread(&WorkerPool::work, worker.get(), static_cast<uint32_t>(this->workers.size()));
+                this->workers.push_back(std::move(worker));
+            }
+
+            auto& worker = *this->workers[slot];
+            {
+                std::lock_guard<std::mutex> lock(worker.mtx);
+                worker.task = std::move(task);
+            }
+
+            worker.var.notify_one();
+        }
+
+        auto get_num_workers() const -> uint32_t {
+            return static_cast<uint32_t>(this->workers.size());
+        }
+
+    private:
+        struct Worker {
+            std::mutex mtx;
+            std::condition_variable var;
+            std::function<void()> task;
+            bool stop = false;
+            std::thread thread;
+        };
+
+        static auto work(Worker* worker, uint32_t slot) -> void {
+            thread_placement().pin(slot);
+            WorkerPool::slot() = static_cast<int32_t>(slot);
+
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(worker->mtx);
+                    worker->var.wait(lock, [worker]() { return worker->stop || worker->task; });
+
+                    if (!worker->task) {
+                        return;
+                    }
+
+                    task = std::move(worker->task);
+                    worker->task = nullptr;
+                }
+
+                task();
+            }
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers;
+};
+
+inline auto worker_pool() -> WorkerPool& {
+    static WorkerPool pool;
+    return pool;
+}
+
+// Tasks of a benchmark phase that are waited for together, replaces a vector of (pinned) threads
+class TaskGroup {
+    public:
+        TaskGroup() = default;
+
+        ~TaskGroup() {
+            this->wait();
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        auto operator=(const TaskGroup&) -> TaskGroup& = delete;
+
+        // Runs f(args...) on the worker of the given slot, same arguments as pinned_thread
+        template<typename F, typename... Args>
+        auto run(uint32_t slot, F&& f, Args&&... args) -> void {
+            auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+
+            if (!WorkerPool::enabled().load()) {
+                this->threads.push_back(pinned_thread(slot, std::move(task)));
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->pending++;
+            }
+
+            worker_pool().execute(slot, [this, task = std::move(task)]() mutable {
+                task();
+
+                // Notified under the lock, the group may be gone as soon as it's released
+                std::lock_guard<std::mutex> lock(this->mtx);
+                this->pending--;
+                this->var.notify_all();
+            });
+        }
+
+        auto wait() -> void {
+            for (auto& thread : this->threads) {
+                thread.join();
+            }
+
+            this->threads.clear();
+
+            std::unique_lock<std::mutex> lock(this->mtx);
+            this->var.wait(lock, [this]() { return this->pending == 0; });
+        }
+
+    private:
+        std::mutex mtx;
+        std::condition_variable var;
+        uint32_t pending = 0;
+        std::vector<std::thread> threads;
+};
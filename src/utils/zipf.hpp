@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+// Zipfian distribution over [0, n), using the method from Gray et al. "Quickly Generating Billion-Record Synthetic Databases"
+// (same as YCSB), only valid for 0 < theta < 1. Construction is O(n), copies are cheap, so construct once and copy into every thread.
+class ZipfDistribution {
+    public:
+        ZipfDistribution(uint64_t n, double theta) : n(std::max<uint64_t>(n, 2)), theta(theta) {
+            this->zeta_n = zeta(this->n, theta);
+            this->alpha = 1.0 / (1.0 - theta);
+            this->eta = (1.0 - std::pow(2.0 / this->n, 1.0 - theta)) / (1.0 - zeta(2, theta) / this->zeta_n);
+            this->half_pow_theta = 1.0 + std::pow(0.5, theta);
+        }
+
+        // Rank of the drawn item, 0 is the most popular one
+        template<typename RNG>
+        auto operator()(RNG& rng) -> uint64_t {
+            auto u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+            auto uz = u * this->zeta_n;
+
+            if (uz < 1.0) {
+                return 0;
+            }
+
+            if (uz < this->half_pow_theta) {
+                return 1;
+            }
+
+            auto rank = static_cast<uint64_t>(this->n * std::pow(this->eta * u - this->eta + 1.0, this->alpha));
+            return std::min(rank, this->n - 1);
+        }
+
+        auto get_n() const -> uint64_t {
+            return this->n;
+        }
+
+    private:
+        static auto zeta(uint64_t n, double theta) -> double {
+            double sum = 0.0;
+
+            for (uint64_t i = 1; i <= n; i++) {
+                sum += 1.0 / std::pow(static_cast<double>(i), theta);
+            }
+
+            return sum;
+        }
+
+        uint64_t n;
+        double theta;
+        double zeta_n;
+        double alpha;
+        double eta;
+        double half_pow_theta;
+};
+
+// Zipfian distribution with popular items scattered over the whole key space, instead of being the lowest keys
+class ScrambledZipfDistribution {
+    public:
+        ScrambledZipfDistribution(uint64_t n, double theta) : zipf(n, theta) {
+        }
+
+        template<typename RNG>
+        auto operator()(RNG& rng) -> uint64_t {
+            return fnv_hash(this->zipf(rng)) % this->zipf.get_n();
+        }
+
+    private:
+        static auto fnv_hash(uint64_t value) -> uint64_t {
+            uint64_t hash = 0xCBF29CE484222325ull;
+
+            for (int i = 0; i < 8; i++) {
+                hash ^= value & 0xFF;
+                hash *= 0x100000001B3ull;
+                value >>= 8;
+            }
+
+            return hash;
+        }
+
+        ZipfDistribution zipf;
+};
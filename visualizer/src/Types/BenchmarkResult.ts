@@ -1,6 +1,30 @@
+export interface TimeSeries {
+    name: string,
+    interval_ms: number,
+    unit: string,
+    time_ns: number[],
+    values: number[],
+}
+
 interface BenchmarkRun {
     value: number,
     hash: number,
+    outlier?: boolean,
+    timeseries?: TimeSeries[],
+    metrics?: { [name: string]: number },
+}
+
+interface BenchmarkStatistics {
+    median: number,
+    mean: number,
+    stddev: number,
+    confidence: number,
+    ci_low: number,
+    ci_high: number,
+    ci_half_width_pct: number,
+    outlier_low: number,
+    outlier_high: number,
+    num_outliers: number,
 }
 
 export interface BenchmarkResult {
@@ -14,6 +38,13 @@ export interface BenchmarkResult {
     avg_value: number,
     mean_value: number,
     max_value: number,
+    num_warmup?: number,
+    statistics?: BenchmarkStatistics,
+    key_size?: number,
+    value_size?: number,
+    allocator?: string,
+    variant?: string,
+    hugepages?: string,
 }
 
 type DeepPartialArr<T extends any[]> =